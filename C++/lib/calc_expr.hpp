@@ -0,0 +1,489 @@
+// calc_expr.hpp — Compiled arithmetic expressions for the calculators
+// compile() parses an infix expression once into a flat RPN program with numbers already
+// converted; eval() then runs it with no allocation, so a formula can be applied to millions
+// of rows. Operators are + - * / ^ (right-associative) and unary minus; identifiers are
+// variables, bound by slot index in the order listed in Program::vars.
+// eval_many() runs a program over whole columns, one op at a time across blocks of kBlock
+// rows, with SSE2/AVX2 loops picked at runtime (detection shared with softgui_raster.hpp).
+// No platform headers: usable from the GUI samples and from headless tools alike.
+
+#ifndef CALC_EXPR_HPP
+#define CALC_EXPR_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cerrno>
+#include <cctype>
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include "softgui_raster.hpp" // Isa, detect_isa, SOFTGUI_TARGET
+
+namespace CalcExpr {
+
+enum class Op : uint8_t { Const, Var, Neg, Add, Sub, Mul, Div, Pow };
+
+struct Instr {
+    Op op;
+    uint32_t slot; // Var: index into the variable array
+    double k;      // Const: the value
+};
+
+const int kMaxStack = 256;   // deepest operand stack a program may need
+const size_t kBlock = 1024;  // rows per column block in eval_many()
+
+using SoftGUI::raster::Isa;
+
+struct Program {
+    std::vector<Instr> code;
+    std::vector<std::string> vars; // slot -> name; may be pre-filled before compile() to fix the layout
+    int max_stack = 0;
+
+    bool empty() const { return code.empty(); }
+    int var_index(std::string_view name) const {
+        for (size_t i = 0; i < vars.size(); ++i) if (vars[i] == name) return (int)i;
+        return -1;
+    }
+};
+
+namespace detail {
+    inline bool is_op_char(char c) { return c=='+'||c=='-'||c=='*'||c=='/'||c=='^'; }
+    inline bool is_ident_start(char c) { return isalpha((unsigned char)c) || c == '_'; }
+    inline bool is_ident_char(char c) { return isalnum((unsigned char)c) || c == '_'; }
+    // 'n' is unary minus: binds tighter than * and /, looser than ^ so -2^2 == -4
+    inline int prec(char op) {
+        if (op=='+'||op=='-') return 1;
+        if (op=='*'||op=='/') return 2;
+        if (op=='n') return 3;
+        if (op=='^') return 4;
+        return 0;
+    }
+    inline Op op_of(char c) {
+        switch (c) {
+            case '+': return Op::Add;
+            case '-': return Op::Sub;
+            case '*': return Op::Mul;
+            case '/': return Op::Div;
+            case '^': return Op::Pow;
+            default:  return Op::Neg;
+        }
+    }
+
+    // x^n by repeated squaring; the vector loops below multiply in the same order, so both agree bit for bit
+    inline double powi(double x, int n) {
+        unsigned m = n < 0 ? 0u - (unsigned)n : (unsigned)n;
+        double r = 1.0, b = x;
+        while (m) {
+            if (m & 1) r *= b;
+            m >>= 1;
+            if (m) b *= b;
+        }
+        return n < 0 ? 1.0 / r : r;
+    }
+    inline bool small_int(double y) { return y >= -64.0 && y <= 64.0 && y == (double)(int)y; }
+    // sqrt for ^0.5, matching std::pow at -0 (+0) and -inf (+inf)
+    inline double pow_half(double x) { return x == -HUGE_VAL ? HUGE_VAL : std::sqrt(x) + 0.0; }
+    inline double pow_fast(double x, double y) {
+        if (small_int(y)) return powi(x, (int)y);
+        if (y == 0.5) return pow_half(x);
+        return std::pow(x, y);
+    }
+
+    // Runs a compiled program; load(slot) supplies variable values. Clears ok on division by zero.
+    template <class Load>
+    inline double run(const Program &p, Load &&load, bool &ok) {
+        double st[kMaxStack];
+        int sp = 0;
+        bool div0 = false;
+        for (const Instr &in : p.code) {
+            switch (in.op) {
+                case Op::Const: st[sp++] = in.k; break;
+                case Op::Var:   st[sp++] = load(in.slot); break;
+                case Op::Neg:   st[sp-1] = -st[sp-1]; break;
+                case Op::Add:   --sp; st[sp-1] += st[sp]; break;
+                case Op::Sub:   --sp; st[sp-1] -= st[sp]; break;
+                case Op::Mul:   --sp; st[sp-1] *= st[sp]; break;
+                case Op::Div:   --sp; div0 |= st[sp] == 0.0; st[sp-1] /= st[sp]; break;
+                case Op::Pow:   --sp; st[sp-1] = pow_fast(st[sp-1], st[sp]); break;
+            }
+        }
+        ok = sp == 1 && !div0;
+        return sp == 1 ? st[0] : 0.0;
+    }
+
+    // ---- column kernels: d[i] = a[i] op b[i], where AK/BK mean that side is the constant ka/kb ----
+    template <Op O>
+    inline double apply(double a, double b) {
+        if constexpr (O == Op::Add) return a + b;
+        else if constexpr (O == Op::Sub) return a - b;
+        else if constexpr (O == Op::Mul) return a * b;
+        else return a / b;
+    }
+
+    template <Op O, bool AK, bool BK>
+    inline void binop_scalar(double *d, const double *a, const double *b, double ka, double kb, size_t n) {
+        for (size_t i = 0; i < n; ++i) d[i] = apply<O>(AK ? ka : a[i], BK ? kb : b[i]);
+    }
+
+    inline void powi_scalar(double *d, const double *a, int e, size_t n) {
+        for (size_t i = 0; i < n; ++i) d[i] = powi(a[i], e);
+    }
+
+    inline void sqrt_scalar(double *d, const double *a, size_t n) {
+        for (size_t i = 0; i < n; ++i) d[i] = pow_half(a[i]);
+    }
+
+    // sign flip, not x * -1: the product keeps a NaN's sign where eval()'s -x flips it
+    inline void neg_scalar(double *d, const double *a, size_t n) {
+        for (size_t i = 0; i < n; ++i) d[i] = -a[i];
+    }
+
+#ifdef SOFTGUI_RASTER_X86
+    template <Op O, bool AK, bool BK>
+    SOFTGUI_TARGET("sse2")
+    inline void binop_sse2(double *d, const double *a, const double *b, double ka, double kb, size_t n) {
+        const __m128d vka = _mm_set1_pd(ka), vkb = _mm_set1_pd(kb);
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            __m128d x = AK ? vka : _mm_loadu_pd(a + i);
+            __m128d y = BK ? vkb : _mm_loadu_pd(b + i);
+            __m128d r;
+            if constexpr (O == Op::Add) r = _mm_add_pd(x, y);
+            else if constexpr (O == Op::Sub) r = _mm_sub_pd(x, y);
+            else if constexpr (O == Op::Mul) r = _mm_mul_pd(x, y);
+            else r = _mm_div_pd(x, y);
+            _mm_storeu_pd(d + i, r);
+        }
+        for (; i < n; ++i) d[i] = apply<O>(AK ? ka : a[i], BK ? kb : b[i]);
+    }
+
+    SOFTGUI_TARGET("sse2")
+    inline void powi_sse2(double *d, const double *a, int e, size_t n) {
+        const unsigned m0 = e < 0 ? 0u - (unsigned)e : (unsigned)e;
+        const __m128d one = _mm_set1_pd(1.0);
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            __m128d r = one, b = _mm_loadu_pd(a + i);
+            for (unsigned m = m0; m; ) {
+                if (m & 1) r = _mm_mul_pd(r, b);
+                m >>= 1;
+                if (m) b = _mm_mul_pd(b, b);
+            }
+            if (e < 0) r = _mm_div_pd(one, r);
+            _mm_storeu_pd(d + i, r);
+        }
+        for (; i < n; ++i) d[i] = powi(a[i], e);
+    }
+
+    SOFTGUI_TARGET("sse2")
+    inline void sqrt_sse2(double *d, const double *a, size_t n) {
+        const __m128d ninf = _mm_set1_pd(-HUGE_VAL), inf = _mm_set1_pd(HUGE_VAL), zero = _mm_setzero_pd();
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            __m128d x = _mm_loadu_pd(a + i);
+            __m128d r = _mm_add_pd(_mm_sqrt_pd(x), zero);
+            __m128d m = _mm_cmpeq_pd(x, ninf);
+            _mm_storeu_pd(d + i, _mm_or_pd(_mm_andnot_pd(m, r), _mm_and_pd(m, inf)));
+        }
+        for (; i < n; ++i) d[i] = pow_half(a[i]);
+    }
+
+    SOFTGUI_TARGET("sse2")
+    inline void neg_sse2(double *d, const double *a, size_t n) {
+        const __m128d sign = _mm_set1_pd(-0.0);
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) _mm_storeu_pd(d + i, _mm_xor_pd(_mm_loadu_pd(a + i), sign));
+        for (; i < n; ++i) d[i] = -a[i];
+    }
+
+    template <Op O, bool AK, bool BK>
+    SOFTGUI_TARGET("avx2")
+    inline void binop_avx2(double *d, const double *a, const double *b, double ka, double kb, size_t n) {
+        const __m256d vka = _mm256_set1_pd(ka), vkb = _mm256_set1_pd(kb);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d x = AK ? vka : _mm256_loadu_pd(a + i);
+            __m256d y = BK ? vkb : _mm256_loadu_pd(b + i);
+            __m256d r;
+            if constexpr (O == Op::Add) r = _mm256_add_pd(x, y);
+            else if constexpr (O == Op::Sub) r = _mm256_sub_pd(x, y);
+            else if constexpr (O == Op::Mul) r = _mm256_mul_pd(x, y);
+            else r = _mm256_div_pd(x, y);
+            _mm256_storeu_pd(d + i, r);
+        }
+        for (; i < n; ++i) d[i] = apply<O>(AK ? ka : a[i], BK ? kb : b[i]);
+    }
+
+    SOFTGUI_TARGET("avx2")
+    inline void powi_avx2(double *d, const double *a, int e, size_t n) {
+        const unsigned m0 = e < 0 ? 0u - (unsigned)e : (unsigned)e;
+        const __m256d one = _mm256_set1_pd(1.0);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d r = one, b = _mm256_loadu_pd(a + i);
+            for (unsigned m = m0; m; ) {
+                if (m & 1) r = _mm256_mul_pd(r, b);
+                m >>= 1;
+                if (m) b = _mm256_mul_pd(b, b);
+            }
+            if (e < 0) r = _mm256_div_pd(one, r);
+            _mm256_storeu_pd(d + i, r);
+        }
+        for (; i < n; ++i) d[i] = powi(a[i], e);
+    }
+
+    SOFTGUI_TARGET("avx2")
+    inline void sqrt_avx2(double *d, const double *a, size_t n) {
+        const __m256d ninf = _mm256_set1_pd(-HUGE_VAL), inf = _mm256_set1_pd(HUGE_VAL), zero = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d x = _mm256_loadu_pd(a + i);
+            __m256d r = _mm256_add_pd(_mm256_sqrt_pd(x), zero);
+            _mm256_storeu_pd(d + i, _mm256_blendv_pd(r, inf, _mm256_cmp_pd(x, ninf, _CMP_EQ_OQ)));
+        }
+        for (; i < n; ++i) d[i] = pow_half(a[i]);
+    }
+
+    SOFTGUI_TARGET("avx2")
+    inline void neg_avx2(double *d, const double *a, size_t n) {
+        const __m256d sign = _mm256_set1_pd(-0.0);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) _mm256_storeu_pd(d + i, _mm256_xor_pd(_mm256_loadu_pd(a + i), sign));
+        for (; i < n; ++i) d[i] = -a[i];
+    }
+#endif
+
+    inline Isa &block_isa() { static Isa isa = SoftGUI::raster::detect_isa(); return isa; }
+
+    // one stack entry of the block evaluator: a column of values, or a constant when p is null
+    struct Slot { const double *p; double k; };
+
+    template <Op O, bool AK, bool BK>
+    inline void binop(double *d, const double *a, const double *b, double ka, double kb, size_t n) {
+#ifdef SOFTGUI_RASTER_X86
+        if (block_isa() == Isa::AVX2) return binop_avx2<O, AK, BK>(d, a, b, ka, kb, n);
+        if (block_isa() == Isa::SSE2) return binop_sse2<O, AK, BK>(d, a, b, ka, kb, n);
+#endif
+        binop_scalar<O, AK, BK>(d, a, b, ka, kb, n);
+    }
+
+    template <Op O>
+    inline void binop(double *d, Slot a, Slot b, size_t n) {
+        if (!a.p) binop<O, true, false>(d, nullptr, b.p, a.k, 0.0, n);
+        else if (!b.p) binop<O, false, true>(d, a.p, nullptr, 0.0, b.k, n);
+        else binop<O, false, false>(d, a.p, b.p, 0.0, 0.0, n);
+    }
+
+    inline void pow_block(double *d, Slot a, Slot b, size_t n) {
+        if (a.p && !b.p && small_int(b.k)) {
+#ifdef SOFTGUI_RASTER_X86
+            if (block_isa() == Isa::AVX2) return powi_avx2(d, a.p, (int)b.k, n);
+            if (block_isa() == Isa::SSE2) return powi_sse2(d, a.p, (int)b.k, n);
+#endif
+            return powi_scalar(d, a.p, (int)b.k, n);
+        }
+        if (a.p && !b.p && b.k == 0.5) {
+#ifdef SOFTGUI_RASTER_X86
+            if (block_isa() == Isa::AVX2) return sqrt_avx2(d, a.p, n);
+            if (block_isa() == Isa::SSE2) return sqrt_sse2(d, a.p, n);
+#endif
+            return sqrt_scalar(d, a.p, n);
+        }
+        // general exponents: no vector pow in the standard library, go element by element
+        for (size_t i = 0; i < n; ++i) d[i] = pow_fast(a.p ? a.p[i] : a.k, b.p ? b.p[i] : b.k);
+    }
+
+    inline void neg_block(double *d, const double *a, size_t n) {
+#ifdef SOFTGUI_RASTER_X86
+        if (block_isa() == Isa::AVX2) return neg_avx2(d, a, n);
+        if (block_isa() == Isa::SSE2) return neg_sse2(d, a, n);
+#endif
+        neg_scalar(d, a, n);
+    }
+
+    inline bool any_zero(Slot s, size_t n) {
+        if (!s.p) return s.k == 0.0;
+        bool z = false;
+        for (size_t i = 0; i < n; ++i) z |= s.p[i] == 0.0;
+        return z;
+    }
+
+    // Evaluates rows [base, base + n), n <= kBlock, into out. scratch holds max_stack blocks.
+    // Returns true if some divisor in the block was zero.
+    inline bool run_block(const Program &p, const double *const *columns, size_t base, size_t n,
+                          double *out, double *scratch) {
+        Slot st[kMaxStack];
+        int sp = 0;
+        bool div0 = false;
+        const Instr *last = &p.code.back();
+        for (const Instr &in : p.code) {
+            if (in.op == Op::Const) { st[sp++] = Slot{nullptr, in.k}; continue; }
+            if (in.op == Op::Var) { st[sp++] = Slot{columns[in.slot] + base, 0.0}; continue; }
+            if (in.op == Op::Neg) {
+                Slot a = st[sp - 1];
+                if (!a.p) { st[sp - 1] = Slot{nullptr, -a.k}; continue; }
+                double *d = &in == last ? out + base : scratch + (size_t)(sp - 1) * kBlock;
+                neg_block(d, a.p, n);
+                st[sp - 1] = Slot{d, 0.0};
+                continue;
+            }
+            Slot a = st[sp - 2], b = st[sp - 1];
+            --sp;
+            Op op = in.op;
+            if (op == Op::Div) div0 |= any_zero(b, n);
+            if (!a.p && !b.p) { // fold constants
+                st[sp - 1] = Slot{nullptr, op == Op::Pow ? pow_fast(a.k, b.k) : op == Op::Add ? a.k + b.k :
+                                  op == Op::Sub ? a.k - b.k : op == Op::Mul ? a.k * b.k : a.k / b.k};
+                continue;
+            }
+            double *d = &in == last ? out + base : scratch + (size_t)(sp - 1) * kBlock;
+            switch (op) {
+                case Op::Add: binop<Op::Add>(d, a, b, n); break;
+                case Op::Sub: binop<Op::Sub>(d, a, b, n); break;
+                case Op::Mul: binop<Op::Mul>(d, a, b, n); break;
+                case Op::Div: binop<Op::Div>(d, a, b, n); break;
+                default:      pow_block(d, a, b, n); break;
+            }
+            st[sp - 1] = Slot{d, 0.0};
+        }
+        Slot r = st[0];
+        if (r.p != out + base)
+            for (size_t i = 0; i < n; ++i) out[base + i] = r.p ? r.p[i] : r.k;
+        return div0;
+    }
+}
+
+// Picks the SIMD level used by eval_many(); requests above what the CPU has are lowered.
+inline void set_eval_isa(Isa want) {
+    Isa best = SoftGUI::raster::detect_isa();
+    detail::block_isa() = (int)want < (int)best ? want : best;
+}
+inline Isa eval_isa() { return detail::block_isa(); }
+
+// Parses expr into out (shunting-yard). New identifiers are appended to out.vars.
+// Returns false with a message in err on a syntax error; out is then left empty.
+inline bool compile(std::string_view expr, Program &out, std::string &err) {
+    using namespace detail;
+    err.clear();
+    out.code.clear();
+    out.max_stack = 0;
+    std::vector<char> ops;
+    bool want_operand = true; // start, after '(' or after an operator
+    auto emit = [&](char t) { out.code.push_back(Instr{op_of(t), 0, 0.0}); };
+    size_t i = 0;
+    while (i < expr.size()) {
+        char c = expr[i];
+        if (isspace((unsigned char)c)) { ++i; continue; }
+        if ((c>='0' && c<='9') || c=='.') {
+            std::string num;
+            while (i < expr.size() && ((expr[i]>='0' && expr[i]<='9') || expr[i]=='.' || expr[i]=='e' || expr[i]=='E' ||
+                    ((expr[i]=='+'||expr[i]=='-') && !num.empty() && (num.back()=='e' || num.back()=='E')))) {
+                num.push_back(expr[i++]);
+            }
+            char *end = nullptr;
+            errno = 0;
+            double v = std::strtod(num.c_str(), &end);
+            if (end == num.c_str() || errno == ERANGE) { err = "Bad number: " + num; out.code.clear(); return false; }
+            out.code.push_back(Instr{Op::Const, 0, v});
+            want_operand = false;
+        } else if (is_ident_start(c)) {
+            size_t s = i;
+            while (i < expr.size() && is_ident_char(expr[i])) ++i;
+            std::string_view name = expr.substr(s, i - s);
+            int slot = out.var_index(name);
+            if (slot < 0) { slot = (int)out.vars.size(); out.vars.emplace_back(name); }
+            out.code.push_back(Instr{Op::Var, (uint32_t)slot, 0.0});
+            want_operand = false;
+        } else if (c == '-' && want_operand) {
+            ops.push_back('n'); // prefix: nothing to pop
+            ++i;
+        } else if (is_op_char(c)) {
+            while (!ops.empty() && ops.back() != '(' &&
+                   (prec(ops.back()) > prec(c) || (prec(ops.back()) == prec(c) && c != '^'))) {
+                emit(ops.back()); ops.pop_back();
+            }
+            ops.push_back(c); ++i;
+            want_operand = true;
+        } else if (c == '(') {
+            ops.push_back(c); ++i;
+            want_operand = true;
+        } else if (c == ')') {
+            while (!ops.empty() && ops.back() != '(') { emit(ops.back()); ops.pop_back(); }
+            if (ops.empty()) { err = "Mismatched parenthesis"; out.code.clear(); return false; }
+            ops.pop_back(); ++i;
+            want_operand = false;
+        } else {
+            err = std::string("Unexpected char: ") + c;
+            out.code.clear();
+            return false;
+        }
+    }
+    while (!ops.empty()) {
+        if (ops.back() == '(') { err = "Mismatched parenthesis"; out.code.clear(); return false; }
+        emit(ops.back()); ops.pop_back();
+    }
+
+    // check operand counts once here so eval() needs no checks
+    int depth = 0;
+    for (const Instr &in : out.code) {
+        if (in.op == Op::Const || in.op == Op::Var) ++depth;
+        else if (in.op == Op::Neg) { if (depth < 1) depth = -1; }
+        else depth = depth < 2 ? -1 : depth - 1;
+        if (depth < 0) break;
+        if (depth > out.max_stack) out.max_stack = depth;
+    }
+    if (depth != 1) { err = "Syntax error"; out.code.clear(); return false; }
+    if (out.max_stack > kMaxStack) { err = "Expression too deep"; out.code.clear(); return false; }
+    return true;
+}
+
+// Evaluates a compiled program. vars[i] is the value of p.vars[i] (may be null if there are none).
+// ok is cleared when a division by zero occurred; the IEEE result (inf/nan) is still returned.
+inline double eval(const Program &p, const double *vars, bool &ok) {
+    return detail::run(p, [vars](uint32_t s) { return vars[s]; }, ok);
+}
+inline double eval(const Program &p, const double *vars = nullptr) {
+    bool ok;
+    return eval(p, vars, ok);
+}
+
+// Evaluates p for rows [0, rows): columns[i][r] is the value of p.vars[i] on row r.
+// Writes out[r] (out must not overlap the columns) and returns how many rows divided by zero.
+// Results are bit-identical to eval() row by row, with one exception: when both operands of
+// + or * are NaN, which of the two propagates is up to the compiler, so the payload/sign of such
+// a NaN may differ. Scratch space is kept per thread.
+inline size_t eval_many(const Program &p, const double *const *columns, size_t rows, double *out) {
+    if (p.code.empty()) return 0;
+    thread_local std::vector<double> scratch;
+    if (scratch.size() < (size_t)p.max_stack * kBlock) scratch.resize((size_t)p.max_stack * kBlock);
+    size_t bad = 0;
+    for (size_t base = 0; base < rows; base += kBlock) {
+        size_t n = std::min(kBlock, rows - base);
+        if (!detail::run_block(p, columns, base, n, out, scratch.data())) continue;
+        // rare: recount exactly which rows divided by zero
+        for (size_t r = base; r < base + n; ++r) {
+            bool ok;
+            detail::run(p, [columns, r](uint32_t s) { return columns[s][r]; }, ok);
+            bad += !ok;
+        }
+    }
+    return bad;
+}
+
+// One-shot compile and evaluate of a constant expression (variables are reported as errors).
+inline double eval_expression(const std::string &expr, bool &ok, std::string &err) {
+    ok = false;
+    Program p;
+    if (!compile(expr, p, err)) return 0.0;
+    if (!p.vars.empty()) { err = "Unknown variable: " + p.vars[0]; return 0.0; }
+    double v = eval(p, nullptr, ok);
+    if (!ok) { err = "Division by zero"; return 0.0; }
+    return v;
+}
+
+} // namespace CalcExpr
+
+#endif // CALC_EXPR_HPP
@@ -55,81 +55,424 @@ void debug(const vector<T> &v) { cerr << "[ "; for (auto &i : v) cerr << i << "
 ll gcdll(ll a, ll b) { return b ? gcdll(b, a % b) : a; }        // Greatest common divisor
 ll lcmll(ll a, ll b) { return a / gcdll(a,b) * b; }             // Least common multiple
 
-bool isPrime(ll n) { // Simple prime check
+bool isPrimeTrial(ll n) { // Simple prime check by trial division, O(sqrt n)
     if (n < 2) return false;
     for (ll i = 2; i * i <= n; ++i) 
         if (n % i == 0) return false;
     return true;
 }
 
-ll factorial(ll n) { return (n <= 1 ? 1 : n * factorial(n - 1)); } // Recursive factorial
+constexpr ull mulmod(ull a, ull b, ull m) { return (ull)((unsigned __int128)a * b % m); } // a*b mod m without overflow
 
-ll nCr(ll n, ll r) { // Combinations: n choose r
+ll factorial(ll n) { // n!, or -1 when it does not fit in ll (n > 20)
+    if (n > 20) return -1;
+    ll r = 1;
+    for (ll i = 2; i <= n; ++i) r *= i;
+    return r;
+}
+
+ll nCr(ll n, ll r) { // Combinations: n choose r, or -1 when the result does not fit in ll
     if (r < 0 || r > n) return 0;
     r = min(r, n - r);
-    ll num = 1, den = 1;
-    for (ll i = 0; i < r; ++i) {
-        num *= (n - i);
-        den *= (i + 1);
+    __int128 res = 1;
+    for (ll i = 1; i <= r; ++i) {
+        res = res * (n - r + i) / i; // exact: res is C(n-r+i, i) after each step
+        if (res > LLONG_MAX) return -1;
     }
-    return num / den;
+    return (ll)res;
 }
 
-ll modpow(ll a, ll e, ll m = MOD) { // Modular exponentiation
-    ll r = 1;
-    while (e) {
-        if (e & 1) r = (r * a) % m;
-        a = (a * a) % m;
+constexpr ll modpow(ll a, ll e, ll m = MOD) { // Modular exponentiation, safe for any 64-bit modulus
+    ll t = a % m;
+    if (t < 0) t += m;
+    ull b = (ull)t, r = 1 % (ull)m;
+    while (e > 0) {
+        if (e & 1) r = mulmod(r, b, m);
+        b = mulmod(b, b, m);
         e >>= 1;
     }
-    return r;
+    return (ll)r;
+}
+
+constexpr ll modinv(ll a, ll m = MOD) { return modpow(a, m - 2, m); } // Inverse for a prime modulus
+
+// Factorials and inverse factorials mod a prime m > n: O(n) setup, then O(1) nCr/nPr queries
+struct FactTable {
+    vll f, inv;
+    ll m;
+    explicit FactTable(int n, ll mod = MOD) : f(n + 1), inv(n + 1), m(mod) {
+        f[0] = 1;
+        for (int i = 1; i <= n; ++i) f[i] = mul(f[i - 1], i);
+        inv[n] = modinv(f[n], m);
+        for (int i = n; i > 0; --i) inv[i - 1] = mul(inv[i], i);
+    }
+    int size() const { return (int)f.size() - 1; }          // largest n covered
+    ll fact(ll n) const { return f[n]; }
+    ll invFact(ll n) const { return inv[n]; }
+    ll nCr_mod(ll n, ll r) const { return r < 0 || r > n ? 0 : mul(mul(f[n], inv[r]), inv[n - r]); }
+    ll nPr_mod(ll n, ll r) const { return r < 0 || r > n ? 0 : mul(f[n], inv[n - r]); }
+private:
+    // moduli below 2^31.5 multiply in plain 64-bit
+    ll mul(ll a, ll b) const { return m < 3037000499LL ? a * b % m : (ll)mulmod(a, b, m); }
+};
+
+// Compile-time table for small n: constexpr FactTableC<1000> t; static_assert(t.nCr_mod(10, 3) == 120);
+template<int N, ll M = MOD>
+struct FactTableC {
+    ll f[N + 1] = {}, inv[N + 1] = {};
+    constexpr FactTableC() {
+        f[0] = 1;
+        for (int i = 1; i <= N; ++i) f[i] = (ll)mulmod(f[i - 1], i, M);
+        inv[N] = modinv(f[N], M);
+        for (int i = N; i > 0; --i) inv[i - 1] = (ll)mulmod(inv[i], i, M);
+    }
+    constexpr ll fact(int n) const { return f[n]; }
+    constexpr ll nCr_mod(int n, int r) const { return r < 0 || r > n ? 0 : (ll)mulmod(mulmod(f[n], inv[r], M), inv[n - r], M); }
+};
+
+// ================== PRIMES ==================
+// Deterministic Miller-Rabin for every 64-bit n: these 7 bases have no strong pseudoprime below 2^64
+bool isPrime(ll n) {
+    if (n < 2) return false;
+    static const int small[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    for (int p : small) {
+        if (n == p) return true;
+        if (n % p == 0) return false;
+    }
+    if (n < 41 * 41) return true;
+    ull u = (ull)n, d = u - 1;
+    int s = 0;
+    while (!(d & 1)) { d >>= 1; ++s; }
+    static const ull bases[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+    for (ull a : bases) {
+        a %= u;
+        if (a == 0) continue;
+        ull x = 1, b = a;
+        for (ull e = d; e; e >>= 1) { // x = a^d mod n
+            if (e & 1) x = mulmod(x, b, u);
+            b = mulmod(b, b, u);
+        }
+        if (x == 1 || x == u - 1) continue;
+        bool composite = true;
+        for (int r = 1; r < s && composite; ++r) {
+            x = mulmod(x, x, u);
+            if (x == u - 1) composite = false;
+        }
+        if (composite) return false;
+    }
+    return true;
+}
+
+// Bulk isPrime: out[i] = 1 when v[i] is prime. threads = 0 uses every core.
+vector<char> isPrime(const vll &v, unsigned threads = 0) {
+    vector<char> out(v.size());
+    if (!threads) threads = max(1u, thread::hardware_concurrency());
+    threads = (unsigned)min<size_t>(threads, max<size_t>(1, v.size() / 4096)); // keep small inputs on this thread
+    auto work = [&](size_t b, size_t e) { for (size_t i = b; i < e; ++i) out[i] = isPrime(v[i]); };
+    if (threads <= 1) { work(0, v.size()); return out; }
+    vector<thread> pool;
+    size_t chunk = (v.size() + threads - 1) / threads;
+    for (unsigned t = 0; t < threads; ++t) {
+        size_t b = t * chunk, e = min(v.size(), b + chunk);
+        if (b < e) pool.emplace_back(work, b, e);
+    }
+    each(th, pool) th.join();
+    return out;
+}
+
+// All primes <= n (plain sieve of Eratosthenes)
+vll primesUpTo(ll n) {
+    vll res;
+    if (n < 2) return res;
+    vector<bool> comp(n + 1);
+    for (ll i = 2; i <= n; ++i) {
+        if (comp[i]) continue;
+        res.push_back(i);
+        for (ll j = i * i; j <= n; j += i) comp[j] = true;
+    }
+    return res;
+}
+
+// Segmented sieve over [lo, hi): calls found(k) for every k in [lo, hi) where prime.
+// Works one cache-sized window at a time; needs the primes up to sqrt(hi), so it suits
+// ranges with hi up to ~1e16 or so. Use isPrime for isolated checks beyond that.
+template<typename F>
+void sieveRange(ll lo, ll hi, F &&found) {
+    lo = max(lo, 2LL);
+    if (lo >= hi) return;
+    ll root = (ll)sqrtl((ld)(hi - 1));
+    while (root * root > hi - 1) --root;
+    while ((root + 1) * (root + 1) <= hi - 1) ++root;
+    vll base = primesUpTo(root);
+    const ll W = 1 << 16;
+    vector<char> comp(W);
+    for (ll s = lo; s < hi; s += W) {
+        ll e = min(hi, s + W);
+        fill(comp.begin(), comp.begin() + (e - s), 0);
+        for (ll p : base) {
+            if (p * p >= e) break;
+            ll j = max(p * p, (s + p - 1) / p * p);
+            for (; j < e; j += p) comp[j - s] = 1;
+        }
+        for (ll k = s; k < e; ++k) if (!comp[k - s]) found(k);
+    }
+}
+
+// Primes in [lo, hi)
+vll primesInRange(ll lo, ll hi) {
+    vll res;
+    sieveRange(lo, hi, [&](ll k) { res.push_back(k); });
+    return res;
+}
+
+// Bitset of [lo, hi): bit i set when lo + i is prime
+vector<bool> primeBitsInRange(ll lo, ll hi) {
+    vector<bool> bits(max(0LL, hi - lo));
+    sieveRange(lo, hi, [&](ll k) { bits[k - lo] = true; });
+    return bits;
 }
 
 // ================== RANDOM HELPERS ==================
+// xoshiro256** (Blackman & Vigna): 32 bytes of state, fast, and a standard URBG, so it also
+// works with <random> distributions and std::shuffle
+struct Xoshiro256 {
+    using result_type = ull;
+    ull s[4];
+
+    explicit Xoshiro256(ull seed = 0x9E3779B97F4A7C15ULL) { reseed(seed); }
+    void reseed(ull seed) { each(w, s) w = splitmix64(seed); } // any seed, even 0, is fine
+    static constexpr ull min() { return 0; }
+    static constexpr ull max() { return ~0ULL; }
+
+    ull operator()() {
+        ull r = rotl(s[1] * 5, 7) * 9, t = s[1] << 17;
+        s[2] ^= s[0]; s[3] ^= s[1]; s[1] ^= s[2]; s[0] ^= s[3];
+        s[2] ^= t; s[3] = rotl(s[3], 45);
+        return r;
+    }
+
+    // advance 2^128 steps: generators jumped 1, 2, 3... times from one seed never overlap
+    void jump() {
+        static const ull J[] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+        ull t[4] = {0, 0, 0, 0};
+        for (ull j : J)
+            for (int b = 0; b < 64; ++b) {
+                if (j & (1ULL << b)) rep(k, 0, 4) t[k] ^= s[k];
+                (*this)();
+            }
+        rep(k, 0, 4) s[k] = t[k];
+    }
+
+    static ull rotl(ull x, int k) { return (x << k) | (x >> (64 - k)); }
+    static ull splitmix64(ull &x) {
+        ull z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+// Four xoshiro256** streams stepped together; the per-lane loops are plain array code the
+// compiler turns into SSE2/AVX2 (x*5 and x*9 as shift+add, no 64-bit vector multiply needed)
+struct Xoshiro256x4 {
+    alignas(32) ull s0[4], s1[4], s2[4], s3[4];
+
+    explicit Xoshiro256x4(Xoshiro256 g) { // lane k starts k+1 jumps past g
+        rep(k, 0, 4) { g.jump(); s0[k] = g.s[0]; s1[k] = g.s[1]; s2[k] = g.s[2]; s3[k] = g.s[3]; }
+    }
+
+    void next(ull out[4]) {
+        rep(k, 0, 4) {
+            ull a = (s1[k] << 2) + s1[k];           // s1 * 5
+            a = (a << 7) | (a >> 57);
+            out[k] = (a << 3) + a;                  // * 9
+            ull t = s1[k] << 17;
+            s2[k] ^= s0[k]; s3[k] ^= s1[k]; s1[k] ^= s2[k]; s0[k] ^= s3[k];
+            s2[k] ^= t; s3[k] = (s3[k] << 45) | (s3[k] >> 19);
+        }
+    }
+};
+
+// This thread's generator, seeded once per thread from the clock, the thread id and a counter,
+// so worker threads never share state or race
+Xoshiro256 &rng64() {
+    static atomic<ull> counter{0};
+    thread_local Xoshiro256 g((ull)chrono::steady_clock::now().time_since_epoch().count() ^
+                              ((ull)hash<thread::id>()(this_thread::get_id()) << 1) ^
+                              (counter++ * 0xD1B54A32D192ED03ULL));
+    return g;
+}
+
+Xoshiro256x4 &rng64x4() { thread_local Xoshiro256x4 g(rng64()); return g; }
+
+// [0, range) from a 32-bit draw without bias (Lemire's multiply-shift with rare rejection); range <= 2^32
+ull boundedDraw(ull x32, ull range, bool &reject) {
+    ull m = x32 * range;
+    reject = (uint32_t)m < range && (uint32_t)m < (uint32_t)((0x100000000ULL - range) % range);
+    return m >> 32;
+}
+
 // Random integer in [l, r]
 int randInt(int l, int r) {
-    static mt19937 rng(chrono::steady_clock::now().time_since_epoch().count());
-    return uniform_int_distribution<int>(l, r)(rng);
+    ull range = (ull)((ll)r - l) + 1;
+    bool reject;
+    ull v;
+    do v = boundedDraw(rng64()() >> 32, range, reject); while (reject);
+    return (int)((ll)l + (ll)v);
 }
 
-// Random double in [l, r]
-double randDouble(double l, double r) {
-    static mt19937 rng(chrono::steady_clock::now().time_since_epoch().count());
-    return uniform_real_distribution<double>(l, r)(rng);
-}
+double unitDouble(ull x) { return (double)(x >> 11) * 0x1.0p-53; } // [0, 1) from the top 53 bits
+
+// Random double in [l, r)
+double randDouble(double l, double r) { return l + (r - l) * unitDouble(rng64()()); }
 
 // Shuffle vector randomly
 template<typename T> 
 void shuffleVec(vector<T> &v) {
-    static mt19937 rng(chrono::steady_clock::now().time_since_epoch().count());
-    shuffle(all(v), rng);
+    shuffle(all(v), rng64());
+}
+
+// Bulk versions for Monte-Carlo style loops: four streams per step, same distributions as above
+void fillUniform(double *out, size_t n, double l = 0.0, double r = 1.0) {
+    Xoshiro256x4 &g = rng64x4();
+    const double scale = r - l;
+    alignas(32) ull x[4];
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        g.next(x);
+        rep(k, 0, 4) out[i + k] = l + scale * unitDouble(x[k]);
+    }
+    if (i < n) { g.next(x); for (int k = 0; i < n; ++i, ++k) out[i] = l + scale * unitDouble(x[k]); }
+}
+
+void fillUniform(int *out, size_t n, int l, int r) {
+    Xoshiro256x4 &g = rng64x4();
+    const ull range = (ull)((ll)r - l) + 1;
+    alignas(32) ull x[4];
+    size_t i = 0;
+    while (i < n) {
+        g.next(x);
+        for (int k = 0; k < 4 && i < n; ++k) {
+            // each 64-bit draw gives two 32-bit candidates
+            for (int half = 0; half < 2 && i < n; ++half) {
+                bool reject;
+                ull v = boundedDraw(half ? x[k] >> 32 : x[k] & 0xFFFFFFFFULL, range, reject);
+                if (!reject) out[i++] = (int)((ll)l + (ll)v);
+            }
+        }
+    }
 }
 
+void fillUniform(vector<double> &v, double l = 0.0, double r = 1.0) { fillUniform(v.data(), v.size(), l, r); }
+void fillUniform(vector<int> &v, int l, int r) { fillUniform(v.data(), v.size(), l, r); }
+
 // ================== STRING HELPERS ==================
-// Remove whitespace from both ends
-str trim(const str &s) {
+// The *View helpers return string_views into the input: no copies, but the input must outlive them.
+
+// Remove whitespace from both ends, as a view
+string_view trimView(string_view s) {
     size_t start = s.find_first_not_of(" \t\n\r");
+    if (start == string_view::npos) return {};
     size_t end = s.find_last_not_of(" \t\n\r");
-    return (start == string::npos) ? "" : s.substr(start, end - start + 1);
+    return s.substr(start, end - start + 1);
+}
+
+// Remove whitespace from both ends
+str trim(const str &s) { return str(trimView(s)); }
+
+// Lazy split: for (string_view f : splitView(line, ',')) ... yields every field, empty ones
+// included ("a,,b," gives 4). Single-char delimiters search with memchr.
+class SplitView {
+public:
+    SplitView(string_view s, char delim) : s_(s), c_(delim), single_(true) {}
+    SplitView(string_view s, string_view delim) : s_(s), d_(delim), c_(delim.empty() ? 0 : delim[0]), single_(delim.size() == 1) {}
+
+    class iterator {
+    public:
+        using iterator_category = forward_iterator_tag;
+        using value_type = string_view;
+        using difference_type = ptrdiff_t;
+        using pointer = const string_view*;
+        using reference = const string_view&;
+
+        iterator() = default;
+        const string_view &operator*() const { return cur_; }
+        const string_view *operator->() const { return &cur_; }
+        iterator &operator++() { advance(); return *this; }
+        iterator operator++(int) { iterator t = *this; advance(); return t; }
+        bool operator==(const iterator &o) const { return done_ == o.done_ && (done_ || next_ == o.next_); }
+        bool operator!=(const iterator &o) const { return !(*this == o); }
+    private:
+        friend class SplitView;
+        iterator(const SplitView *r, const char *p, const char *end) : r_(r), next_(p), end_(end) { advance(); }
+        void advance() {
+            if (!next_) { done_ = true; return; } // the last field was already handed out
+            size_t left = (size_t)(end_ - next_);
+            const char *hit = nullptr;
+            size_t skip = 1;
+            if (left && r_->single_) {
+                hit = (const char*)memchr(next_, r_->c_, left);
+            } else if (left && !r_->d_.empty()) {
+                size_t k = string_view(next_, left).find(r_->d_);
+                if (k != string_view::npos) hit = next_ + k;
+                skip = r_->d_.size();
+            }
+            if (hit) { cur_ = string_view(next_, (size_t)(hit - next_)); next_ = hit + skip; }
+            else { cur_ = string_view(next_, left); next_ = nullptr; }
+        }
+        const SplitView *r_ = nullptr;
+        const char *next_ = nullptr, *end_ = nullptr;
+        string_view cur_;
+        bool done_ = false;
+    };
+
+    iterator begin() const {
+        const char *b = s_.data() ? s_.data() : "";
+        return iterator(this, b, b + s_.size());
+    }
+    iterator end() const { iterator e; e.done_ = true; return e; }
+private:
+    string_view s_, d_;
+    char c_;
+    bool single_;
+};
+
+SplitView splitView(string_view s, char delim) { return SplitView(s, delim); }
+SplitView splitView(string_view s, string_view delim) { return SplitView(s, delim); }
+
+// Split into out (cleared first); reusing one vector across lines keeps parsing allocation-free
+void splitInto(string_view s, char delim, vector<string_view> &out) {
+    out.clear();
+    for (string_view f : splitView(s, delim)) out.push_back(f);
 }
 
-// Split string by delimiter
+// Split string by delimiter (like getline: a trailing empty field is dropped)
 vs split(const str &s, char delim) {
-    vs res; stringstream ss(s); str item;
-    while (getline(ss, item, delim)) res.push_back(item);
+    vs res;
+    for (string_view f : splitView(s, delim)) res.emplace_back(f);
+    if (!res.empty() && res.back().empty()) res.pop_back();
     return res;
 }
 
-// Join vector of strings with separator
-str join(const vs &v, const str &sep) {
-    stringstream ss;
-    for (size_t i = 0; i < v.size(); ++i) {
-        if (i) ss << sep;
-        ss << v[i];
+// Join any range of strings/string_views with separator, allocating the result once
+template<typename R>
+str join(const R &parts, string_view sep) {
+    size_t n = 0, count = 0;
+    for (const auto &p : parts) { n += string_view(p).size(); ++count; }
+    str res;
+    res.reserve(n + (count ? count - 1 : 0) * sep.size());
+    bool first = true;
+    for (const auto &p : parts) {
+        if (!first) res.append(sep);
+        res.append(string_view(p));
+        first = false;
     }
-    return ss.str();
+    return res;
 }
 
+// Join vector of strings with separator
+str join(const vs &v, const str &sep) { return join<vs>(v, string_view(sep)); }
+
 // Convert string to lowercase
 str toLower(str s) { transform(all(s), s.begin(), ::tolower); return s; }
 
@@ -137,21 +480,29 @@ str toLower(str s) { transform(all(s), s.begin(), ::tolower); return s; }
 str toUpper(str s) { transform(all(s), s.begin(), ::toupper); return s; }
 
 // ================== FILE HELPERS ==================
-// Read file into string
+// Read file into string (binary: bytes come back exactly as stored)
 str readFile(const str &filename) {
-    ifstream in(filename);
+    ifstream in(filename, ios::binary | ios::ate);
     if (!in) return "";
-    stringstream buffer;
-    buffer << in.rdbuf();
-    return buffer.str();
+    streamoff size = in.tellg();
+    in.seekg(0);
+    if (size <= 0) { // size unknown (pipe, device): stream it
+        stringstream buffer;
+        buffer << in.rdbuf();
+        return buffer.str();
+    }
+    str s((size_t)size, '\0');
+    in.read(&s[0], size);
+    s.resize((size_t)in.gcount());
+    return s;
 }
 
-// Write string to file
+// Write string to file (binary: no newline translation)
 bool writeFile(const str &filename, const str &content) {
-    ofstream out(filename);
+    ofstream out(filename, ios::binary);
     if (!out) return false;
-    out << content;
-    return true;
+    out.write(content.data(), (streamsize)content.size());
+    return (bool)out;
 }
 
 #ifdef ALIAS_MAIN // Optional menu-based program section
@@ -270,4 +621,146 @@ int main() {
 }
 
 #endif // ALIAS_MAIN
+
+#ifdef ALIAS_BENCH // Optional benchmark program: compile one file with -DALIAS_BENCH -O2
+
+template<typename F>
+double benchMs(F &&f) {
+    auto t0 = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+void bench_primes() {
+    println("--- Primes ---");
+    // trial division vs Miller-Rabin, same inputs, same answers
+    ll lo = 1000000000000LL, n = 20000, cT = 0, cM = 0;
+    double tT = benchMs([&] { for (ll k = lo; k < lo + n; ++k) cT += isPrimeTrial(k); });
+    double tM = benchMs([&] { for (ll k = lo; k < lo + n; ++k) cM += isPrime(k); });
+    println("isPrime on ", n, " numbers near 1e12: trial ", tT, " ms, Miller-Rabin ", tM, " ms", cT == cM ? "" : "  MISMATCH");
+    ll big = 1000000000000000003LL; // prime, so trial division runs all the way to 1e9
+    bool pT = false, pM = false;
+    tT = benchMs([&] { pT = isPrimeTrial(big); });
+    tM = benchMs([&] { pM = isPrime(big); });
+    println("isPrime(", big, "): trial ", tT, " ms, Miller-Rabin ", tM, " ms", pT == pM ? "" : "  MISMATCH");
+
+    // segmented sieve vs one isPrime per number
+    ll s = 1000000000LL, w = 10000000;
+    size_t cS = 0; ll cI = 0;
+    double tS = benchMs([&] { cS = primesInRange(s, s + w).size(); });
+    double tI = benchMs([&] { for (ll k = s; k < s + w; ++k) cI += isPrime(k); });
+    println("primes in [1e9, 1e9+1e7): sieve ", tS, " ms, isPrime loop ", tI, " ms, count ", cS, (ll)cS == cI ? "" : "  MISMATCH");
+
+    // bulk isPrime, one thread vs all cores
+    vll v(1 << 20);
+    mt19937_64 rng(7);
+    each(x, v) x = (ll)(rng() >> 2) | 1;
+    vector<char> r1, rN;
+    double t1 = benchMs([&] { r1 = isPrime(v, 1); });
+    double tN = benchMs([&] { rN = isPrime(v); });
+    println("bulk isPrime on ", v.size(), " 62-bit numbers: 1 thread ", t1, " ms, ", thread::hardware_concurrency(), " threads ", tN, " ms", r1 == rN ? "" : "  MISMATCH");
+}
+
+void bench_combinatorics() {
+    println("--- Combinatorics ---");
+    const int N = 1000000, Q = 10000000;
+    FactTable t(N);
+    mt19937 rng(11);
+    vector<pii> qs(Q);
+    each(q, qs) { q.first = (int)(rng() % N); q.second = (int)(rng() % (q.first + 1)); }
+    ll sT = 0, sL = 0;
+    double tT = benchMs([&] { each(q, qs) sT += t.nCr_mod(q.first, q.second); });
+    // per-call O(r) product with one modular inverse, on a slice of the queries
+    const int S = Q / 100000;
+    double tL = benchMs([&] {
+        for (int i = 0; i < S; ++i) {
+            ll n = qs[i].first, r = min(qs[i].second, qs[i].first - qs[i].second), num = 1, den = 1;
+            for (ll k = 1; k <= r; ++k) { num = num * ((n - r + k) % MOD) % MOD; den = den * k % MOD; }
+            sL += num * modinv(den) % MOD;
+        }
+    }) * (Q / S);
+    ll check = 0;
+    for (int i = 0; i < S; ++i) check += t.nCr_mod(qs[i].first, qs[i].second);
+    println("nCr mod p, ", Q, " queries with n < ", N, ": table ", tT, " ms (checksum ", sT, "), per-call product ~", (ll)tL, " ms extrapolated from ", S, check == sL ? "" : "  MISMATCH");
+    constexpr FactTableC<64> small;
+    static_assert(small.nCr_mod(10, 3) == 120, "compile-time table");
+    println("modpow(3, 1e18, 2^61-1) = ", modpow(3, (ll)1e18, (1LL << 61) - 1), ", 62! mod p from constexpr table = ", small.fact(62));
+}
+
+void bench_strings() {
+    println("--- Strings ---");
+    // ~50 MB of CSV-like lines
+    str text;
+    mt19937 rng(5);
+    for (int i = 0; i < 1000000; ++i)
+        text += "  " + to_string(i) + "," + to_string(rng()) + ",alpha," + to_string(rng() % 1000) + ".25,,x\n";
+    size_t fS = 0, fV = 0, bytes = 0;
+    double tS = benchMs([&] {
+        for (const str &line : split(text, '\n'))
+            for (const str &f : split(trim(line), ',')) { ++fS; bytes += f.size(); }
+    });
+    vector<string_view> fields, every;
+    double tV = benchMs([&] {
+        for (string_view line : splitView(text, '\n')) {
+            splitInto(trimView(line), ',', fields);
+            fV += fields.size();
+        }
+    });
+    for (string_view f : splitView(text, ',')) every.push_back(f);
+    str joined;
+    double tJ = benchMs([&] { joined = join(every, ","); });
+    println("split ", text.size() >> 20, " MB into fields: strings ", tS, " ms (", fS, " fields, ", bytes, " bytes), views ", tV, " ms (", fV, " fields, the final empty line included)");
+    println("join of ", every.size(), " views: ", tJ, " ms", joined == text ? "" : "  MISMATCH");
+}
+
+void bench_random() {
+    println("--- Random ---");
+    const size_t N = 1 << 24;
+    vector<double> d(N);
+    vector<int> v(N);
+    double tOld = benchMs([&] {
+        for (auto &x : d) {
+            static mt19937 rng(1);
+            x = uniform_real_distribution<double>(0.0, 1.0)(rng);
+        }
+    });
+    double tOne = benchMs([&] { each(x, d) x = randDouble(0.0, 1.0); });
+    double tFill = benchMs([&] { fillUniform(d); });
+    double tInt = benchMs([&] { fillUniform(v, 1, 6); });
+    double mean = 0;
+    each(x, d) mean += x;
+    ll dice = 0;
+    each(x, v) dice += x;
+    println(N, " doubles: mt19937 + distribution ", tOld, " ms, randDouble ", tOne, " ms, fillUniform ", tFill, " ms (mean ", mean / N, ")");
+    println(N, " dice rolls with fillUniform: ", tInt, " ms (mean ", (double)dice / N, ")");
+    // Monte-Carlo pi on every core, each thread on its own generator
+    unsigned T = max(1u, thread::hardware_concurrency());
+    vector<ll> hits(T);
+    double tPi = benchMs([&] {
+        vector<thread> pool;
+        rep(t, 0, (int)T) pool.emplace_back([&hits, t] {
+            vector<double> xy(1 << 16);
+            ll h = 0;
+            rep(round, 0, 64) {
+                fillUniform(xy);
+                for (size_t i = 0; i < xy.size(); i += 2) h += xy[i] * xy[i] + xy[i + 1] * xy[i + 1] < 1.0;
+            }
+            hits[t] = h;
+        });
+        each(th, pool) th.join();
+    });
+    ll total = 0;
+    each(h, hits) total += h;
+    println("pi ~ ", 4.0 * total / ((double)T * 64 * (1 << 15)), " from ", T, " threads in ", tPi, " ms");
+}
+
+int main() {
+    bench_primes();
+    bench_combinatorics();
+    bench_strings();
+    bench_random();
+    return 0;
+}
+
+#endif // ALIAS_BENCH
 #endif // ALIAS_HPP
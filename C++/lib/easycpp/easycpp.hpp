@@ -26,12 +26,27 @@
 #include <filesystem>
 #include <random>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <deque>
+#include <atomic>
+#include <exception>
+#include <type_traits>
 
 #ifdef _WIN32
     #include <windows.h>
     #include <commdlg.h>
     #include <gdiplus.h>
     #pragma comment (lib, "gdiplus.lib")
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
 #endif
 
 // ---------------------------------------------------------------------------
@@ -61,19 +76,177 @@ namespace EasyCPP {
     inline void sleep_ms(int ms) { this_thread::sleep_for(chrono::milliseconds(ms)); }
     inline void sleep_s(int s)   { this_thread::sleep_for(chrono::seconds(s)); }
 
-    // ---------- Random ----------
-    inline int randint(int min, int max) {
-        static mt19937 rng((unsigned)chrono::steady_clock::now().time_since_epoch().count());
-        uniform_int_distribution<int> dist(min, max);
-        return dist(rng);
+    // ---------- Tasks ----------
+    // Work-stealing pool: each worker has its own deque. Tasks a worker submits go on its own
+    // deque (LIFO, cache-warm), others are dealt round-robin, and idle workers steal the oldest
+    // task from a busy one. Keep widget access on the UI thread: finish with Window::post.
+    //     auto f = EasyCPP::async([]{ return heavy(); });
+    //     EasyCPP::async([&win, lbl]{ auto s = heavy(); win.post([lbl, s]{ lbl->text = s; lbl->mark_dirty(); }); });
+    class thread_pool {
+    public:
+        explicit thread_pool(unsigned threads = 0)
+            : n_(threads ? threads : max(1u, thread::hardware_concurrency())) {
+            for (unsigned i = 0; i < n_; ++i) queues_.emplace_back(new queue);
+            workers_.reserve(n_);
+            for (unsigned i = 0; i < n_; ++i) workers_.emplace_back([this, i] { run(i); });
+        }
+        // runs whatever is still queued, then joins
+        ~thread_pool() {
+            {
+                lock_guard<mutex> lk(wake_m_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto& t : workers_) t.join();
+        }
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        unsigned size() const { return n_; }
+
+        void submit(function<void()> task) {
+            unsigned q = worker_of() == this ? worker_index() : next_++ % size();
+            {
+                lock_guard<mutex> lk(queues_[q]->m);
+                queues_[q]->tasks.push_back(move(task));
+            }
+            {
+                lock_guard<mutex> lk(wake_m_);
+                ++pending_;
+            }
+            wake_.notify_one();
+        }
+
+        // runs fn on the pool; the future carries its result or exception
+        template<typename F>
+        auto async(F&& fn) -> future<invoke_result_t<decay_t<F>>> {
+            using R = invoke_result_t<decay_t<F>>;
+            auto task = make_shared<packaged_task<R()>>(forward<F>(fn));
+            future<R> res = task->get_future();
+            submit([task] { (*task)(); });
+            return res;
+        }
+
+        // true on the pool's own worker threads
+        bool in_worker() const { return worker_of() == this; }
+
+    private:
+        struct queue {
+            mutex m;
+            deque<function<void()>> tasks;
+        };
+
+        static const thread_pool*& worker_of() { static thread_local const thread_pool* p = nullptr; return p; }
+        static unsigned& worker_index() { static thread_local unsigned i = 0; return i; }
+
+        bool try_pop(unsigned self, function<void()>& out) {
+            {
+                queue& q = *queues_[self];
+                lock_guard<mutex> lk(q.m);
+                if (!q.tasks.empty()) { out = move(q.tasks.back()); q.tasks.pop_back(); return true; }
+            }
+            for (unsigned k = 1; k < size(); ++k) {
+                queue& q = *queues_[(self + k) % size()];
+                lock_guard<mutex> lk(q.m);
+                if (!q.tasks.empty()) { out = move(q.tasks.front()); q.tasks.pop_front(); return true; }
+            }
+            return false;
+        }
+
+        void run(unsigned self) {
+            worker_of() = this;
+            worker_index() = self;
+            function<void()> task;
+            for (;;) {
+                if (try_pop(self, task)) {
+                    {
+                        lock_guard<mutex> lk(wake_m_);
+                        --pending_;
+                    }
+                    task(); // packaged_task stores exceptions; plain submit() tasks must not throw
+                    task = nullptr;
+                    continue;
+                }
+                unique_lock<mutex> lk(wake_m_);
+                if (stop_ && pending_ == 0) return;
+                // pending_ may be nonzero while another worker is between pop and decrement; just retry
+                wake_.wait(lk, [this] { return pending_ > 0 || stop_; });
+                if (stop_ && pending_ == 0) return;
+            }
+        }
+
+        const unsigned n_;
+        vector<unique_ptr<queue>> queues_;
+        vector<thread> workers_;
+        mutex wake_m_;
+        condition_variable wake_;
+        size_t pending_ = 0;  // queued but not yet started, guarded by wake_m_
+        bool stop_ = false;
+        atomic<unsigned> next_{0};
+    };
+
+    // process-wide pool, created on first use
+    inline thread_pool& default_pool() {
+        static thread_pool pool;
+        return pool;
     }
 
-    inline double randf(double min, double max) {
-        static mt19937 rng((unsigned)chrono::steady_clock::now().time_since_epoch().count());
-        uniform_real_distribution<double> dist(min, max);
-        return dist(rng);
+    template<typename F>
+    inline auto async(F&& fn) { return default_pool().async(forward<F>(fn)); }
+
+    // Calls fn(i) for every i in [begin, end) across the pool, in chunks of grain indices
+    // (0 picks one). The calling thread works too, so this is safe to call from inside a task.
+    // Returns when all calls are done; the first exception thrown is rethrown here.
+    template<typename F>
+    inline void parallel_for(size_t begin, size_t end, F&& fn, size_t grain = 0, thread_pool& pool = default_pool()) {
+        if (begin >= end) return;
+        size_t n = end - begin;
+        if (!grain) grain = max<size_t>(1, n / (pool.size() * 8));
+        size_t chunks = (n + grain - 1) / grain;
+        if (chunks == 1) { for (size_t i = begin; i < end; ++i) fn(i); return; }
+
+        struct shared_state {
+            atomic<size_t> next{0}, done{0};
+            mutex m;
+            condition_variable cv;
+            exception_ptr error;
+        };
+        auto st = make_shared<shared_state>();
+        auto work = [st, begin, end, grain, chunks, &fn] {
+            size_t c;
+            while ((c = st->next++) < chunks) {
+                size_t b = begin + c * grain, e = min(end, b + grain);
+                try {
+                    for (size_t i = b; i < e; ++i) fn(i);
+                } catch (...) {
+                    lock_guard<mutex> lk(st->m);
+                    if (!st->error) st->error = current_exception();
+                }
+                if (++st->done == chunks) {
+                    lock_guard<mutex> lk(st->m);
+                    st->cv.notify_all();
+                }
+            }
+        };
+        // helpers that start after every chunk is taken return at once, so fn is not used past this call
+        size_t helpers = min<size_t>(pool.size(), chunks - 1);
+        for (size_t h = 0; h < helpers; ++h) pool.submit(work);
+        work();
+        unique_lock<mutex> lk(st->m);
+        st->cv.wait(lk, [&] { return st->done == chunks; });
+        if (st->error) rethrow_exception(st->error);
     }
 
+    // ---------- Random ----------
+    // all backed by alias.hpp's per-thread xoshiro256** (rng64), so safe from worker threads
+    inline int randint(int min, int max) { return randInt(min, max); }       // [min, max]
+    inline double randf(double min, double max) { return randDouble(min, max); } // [min, max)
+
+    inline void fill_uniform(vector<int>& v, int min, int max) { fillUniform(v, min, max); }
+    inline void fill_uniform(vector<double>& v, double min = 0.0, double max = 1.0) { fillUniform(v, min, max); }
+    inline void fill_uniform(int* out, size_t n, int min, int max) { fillUniform(out, n, min, max); }
+    inline void fill_uniform(double* out, size_t n, double min = 0.0, double max = 1.0) { fillUniform(out, n, min, max); }
+
     // ---------- File Helpers ----------
     inline bool file_exists(const string& path) {
         return filesystem::exists(path);
@@ -91,6 +264,165 @@ namespace EasyCPP {
         f << data;
     }
 
+    // Binary read in one call into a buffer sized from the file; "" if it can't be opened
+    inline string read_file_fast(const string& path) {
+        string out;
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) return out;
+        error_code ec;
+        uintmax_t size = filesystem::file_size(path, ec);
+        if (!ec && size) {
+            out.resize((size_t)size);
+            out.resize(fread(&out[0], 1, out.size(), f)); // the file may have shrunk meanwhile
+        }
+        // unknown size, or the file grew: read on in blocks
+        char block[65536];
+        size_t n;
+        while ((n = fread(block, 1, sizeof(block), f)) > 0) out.append(block, n);
+        fclose(f);
+        return out;
+    }
+
+    // Read-only memory mapping of a whole file (CreateFileMapping / mmap). Pages are read
+    // on first touch, so opening is cheap even for huge files. Move-only.
+    class mapped_file {
+    public:
+        mapped_file() = default;
+        explicit mapped_file(const string& path) { open(path); }
+        ~mapped_file() { close(); }
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+        mapped_file(mapped_file&& o) noexcept { *this = std::move(o); }
+        mapped_file& operator=(mapped_file&& o) noexcept {
+            if (this != &o) {
+                close();
+                data_ = o.data_; size_ = o.size_; open_ = o.open_;
+                o.data_ = nullptr; o.size_ = 0; o.open_ = false;
+            }
+            return *this;
+        }
+
+        bool open(const string& path) {
+            close();
+#ifdef _WIN32
+            HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                      OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return false;
+            LARGE_INTEGER sz;
+            bool ok = GetFileSizeEx(file, &sz) != 0;
+            if (ok && sz.QuadPart > 0) {
+                HANDLE map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (map) {
+                    data_ = (const char*)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+                    CloseHandle(map); // the view keeps the mapping alive
+                }
+                ok = data_ != nullptr;
+                if (ok) size_ = (size_t)sz.QuadPart;
+            }
+            CloseHandle(file);
+#else
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return false;
+            struct stat st;
+            bool ok = fstat(fd, &st) == 0;
+            if (ok && st.st_size > 0) {
+                void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                ok = p != MAP_FAILED;
+                if (ok) { data_ = (const char*)p; size_ = (size_t)st.st_size; }
+            }
+            ::close(fd);
+#endif
+            open_ = ok; // an empty file opens with an empty view
+            return ok;
+        }
+
+        void close() {
+            if (data_) {
+#ifdef _WIN32
+                UnmapViewOfFile(data_);
+#else
+                munmap((void*)data_, size_);
+#endif
+            }
+            data_ = nullptr; size_ = 0; open_ = false;
+        }
+
+        bool is_open() const { return open_; }
+        const char* data() const { return data_; }
+        size_t size() const { return size_; }
+        string_view view() const { return data_ ? string_view(data_, size_) : string_view(); }
+
+    private:
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+        bool open_ = false;
+    };
+
+    // Streams a file in fixed-size blocks and hands out one line at a time as a view into the
+    // block buffer (valid until the next call). "\r\n" endings are trimmed; a line longer than
+    // the block grows the buffer.
+    //     line_reader r("log.txt"); string_view line; while (r.next(line)) ...
+    class line_reader {
+    public:
+        explicit line_reader(const string& path, size_t block = 1 << 20)
+            : f_(fopen(path.c_str(), "rb")), buf_(max<size_t>(block, 64)) {}
+        ~line_reader() { if (f_) fclose(f_); }
+        line_reader(const line_reader&) = delete;
+        line_reader& operator=(const line_reader&) = delete;
+
+        bool is_open() const { return f_ != nullptr; }
+
+        bool next(string_view& line) {
+            for (;;) {
+                const char* nl = begin_ < end_ ? (const char*)memchr(&buf_[begin_], '\n', end_ - begin_) : nullptr;
+                if (nl) {
+                    size_t len = nl - &buf_[begin_];
+                    line = string_view(&buf_[begin_], len);
+                    begin_ += len + 1;
+                    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+                    return true;
+                }
+                if (!refill()) {
+                    if (begin_ == end_) return false;
+                    line = string_view(&buf_[begin_], end_ - begin_); // last line, no newline
+                    begin_ = end_;
+                    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+                    return true;
+                }
+            }
+        }
+
+    private:
+        // moves the unfinished line to the front and reads the next block after it
+        bool refill() {
+            if (!f_ || eof_) return false;
+            size_t keep = end_ - begin_;
+            if (begin_) memmove(&buf_[0], &buf_[begin_], keep);
+            begin_ = 0; end_ = keep;
+            if (end_ == buf_.size()) buf_.resize(buf_.size() * 2);
+            size_t n = fread(&buf_[end_], 1, buf_.size() - end_, f_);
+            if (n == 0) { eof_ = true; return false; }
+            end_ += n;
+            return true;
+        }
+
+        FILE* f_;
+        vector<char> buf_;
+        size_t begin_ = 0, end_ = 0;
+        bool eof_ = false;
+    };
+
+    // Calls fn(string_view) for every line of a file; returns the number of lines, or -1 if it can't be opened
+    template<typename F>
+    inline long long for_each_line(const string& path, F&& fn, size_t block = 1 << 20) {
+        line_reader r(path, block);
+        if (!r.is_open()) return -1;
+        long long count = 0;
+        string_view line;
+        while (r.next(line)) { fn(line); ++count; }
+        return count;
+    }
+
     // ---------- Math Helpers ----------
     template<typename T>
     inline T clamp(T v, T lo, T hi) {
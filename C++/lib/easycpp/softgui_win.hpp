@@ -15,6 +15,8 @@
 #include <cstring>
 #include <algorithm>
 #include <chrono>
+#include <mutex>
+#include <deque>
 
 namespace SoftGUI {
 
@@ -31,6 +33,10 @@ struct Geometry { int x=0,y=0,w=100,h=24; };
 // ---------- Forward ----------
 struct Widget;
 class Window;
+
+// message that drains Window::post on the UI thread (WM_APP + 0x120 is taken by img_rnd.hpp)
+const UINT WM_SOFTGUI_POST = WM_APP + 0x100;
+
 using WidgetPtr = std::shared_ptr<Widget>;
 
 // ---------- Pack options (very small subset of Tk pack) ----------
@@ -327,6 +333,16 @@ public:
     HWND hwnd() const { return hwnd_; }
 
     void set_title(const char* t) { title_ = t; SetWindowTextA(hwnd_, t); }
+
+    // Queue fn to run on the UI thread; safe to call from any thread, e.g. to apply a worker's
+    // results to widgets. Tasks still queued when the window is destroyed are dropped.
+    void post(std::function<void()> fn) {
+        std::lock_guard<std::mutex> lk(post_mu_);
+        posted_.push_back(std::move(fn));
+        if (post_pending_ || !hwnd_) return; // one message per batch
+        // a failed post (full message queue) leaves the flag clear so the next post() retries
+        post_pending_ = PostMessageA(hwnd_, WM_SOFTGUI_POST, 0, 0) != FALSE;
+    }
     void resize(int w,int h) { width_=w; height_=h; SetWindowPos(hwnd_, NULL,0,0,w,h, SWP_NOMOVE|SWP_NOZORDER); recompute_layout(); InvalidateRect(hwnd_, NULL, TRUE); }
 
 private:
@@ -334,6 +350,9 @@ private:
     std::string title_;
     HWND hwnd_ = NULL;
     WNDCLASSEXA wc_{};
+    std::mutex post_mu_;
+    std::deque<std::function<void()>> posted_; // Window::post queue, drained on WM_SOFTGUI_POST
+    bool post_pending_ = false;                // a WM_SOFTGUI_POST is queued (guarded by post_mu_)
     HINSTANCE hInst_ = GetModuleHandleA(NULL);
 
     // top-level widget storage (we own shared_ptr)
@@ -422,6 +441,17 @@ private:
         return DefWindowProcA(hwnd, msg, wParam, lParam);
     }
 
+    // run everything posted so far; tasks posted meanwhile arrive with the next message
+    void run_posted() {
+        std::deque<std::function<void()>> batch;
+        {
+            std::lock_guard<std::mutex> lk(post_mu_);
+            batch.swap(posted_);
+            post_pending_ = false;
+        }
+        for (auto &fn : batch) if (fn) fn();
+    }
+
     // main instance wndproc with double-buffered painting
     LRESULT wndproc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         switch (msg) {
@@ -519,6 +549,9 @@ private:
                 recompute_layout();
                 InvalidateRect(hwnd, NULL, TRUE);
                 return 0;
+            case WM_SOFTGUI_POST:
+                run_posted();
+                return 0;
             case WM_DESTROY:
                 PostQuitMessage(0);
                 return 0;
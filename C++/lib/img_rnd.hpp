@@ -1,15 +1,32 @@
 // img_rnd.hpp — Simple image renderer for SoftGUI
-// Requires linking with: -lgdiplus
+// Requires linking with: -lgdiplus -lmsimg32 -lshlwapi
 
 #ifndef IMG_RND_HPP
 #define IMG_RND_HPP
 
 #include <windows.h>
 #include <gdiplus.h>
+#include <shlwapi.h>
 #include <string>
 #include <memory>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <climits>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
 
 #pragma comment (lib, "gdiplus.lib")
+#pragma comment (lib, "msimg32.lib")
+#pragma comment (lib, "shlwapi.lib")
 
 namespace ImgRnd {
 
@@ -31,41 +48,679 @@ private:
 // Singleton instance — initialized once
 inline GDIPlusInit gdiInit;
 
+// -------------------- Scaled-bitmap cache --------------------
+// The image resampled to one target size, kept as a premultiplied 32bpp DIB section.
+// When the whole scaled image is over budget only an area around the view is cached.
+struct ScaledCache {
+    HDC dc = NULL;
+    HBITMAP bm = NULL;
+    HGDIOBJ old = NULL;
+    void* bits = nullptr;
+    int capW = 0, capH = 0;        // allocated DIB size (grow-only)
+    int targetW = 0, targetH = 0;  // scaled image size the contents were rendered for
+    RECT part{};                   // cached area, in scaled-image pixels
+
+    ScaledCache() = default;
+    ScaledCache(const ScaledCache&) = delete;
+    ScaledCache& operator=(const ScaledCache&) = delete;
+    ~ScaledCache() { Release(); }
+
+    bool Covers(int tw, int th, const RECT& r) const {
+        return bm && tw == targetW && th == targetH &&
+               r.left >= part.left && r.top >= part.top && r.right <= part.right && r.bottom <= part.bottom;
+    }
+    void Invalidate() { targetW = targetH = 0; }
+
+    bool Reserve(int w, int h) {
+        if (bm && w <= capW && h <= capH) return true;
+        w = std::max(w, capW); h = std::max(h, capH);
+        Release();
+        BITMAPINFO bmi{};
+        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bmi.bmiHeader.biWidth = w;
+        bmi.bmiHeader.biHeight = -h; // top-down, so rows match a GDI+ bitmap with positive stride
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+        bm = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+        if (!bm) return false;
+        dc = CreateCompatibleDC(NULL);
+        old = SelectObject(dc, bm);
+        capW = w; capH = h;
+        return true;
+    }
+    void Release() {
+        if (dc) { SelectObject(dc, old); DeleteDC(dc); dc = NULL; }
+        if (bm) { DeleteObject(bm); bm = NULL; }
+        bits = nullptr;
+        capW = capH = 0;
+        Invalidate();
+    }
+};
+
+// -------------------- Tile pyramid --------------------
+// Optional mipmap pyramid for very large images: level n is the image halved n times, cut
+// into kTileSize squares. Level 0 tiles are copied from the source on first use; a tile of
+// level n is box-filtered from the four level n-1 tiles under it, so each step halves the
+// one below instead of resampling the full image. Tiles are evicted least-recently-used once
+// the pyramid holds more than its byte budget.
+class TilePyramid {
+public:
+    static constexpr int kTileSize = 256;
+
+    struct Stats { size_t hits = 0, misses = 0, evictions = 0, bytes = 0, tiles = 0; };
+
+    TilePyramid() = default;
+    TilePyramid(const TilePyramid&) = delete;
+    TilePyramid& operator=(const TilePyramid&) = delete;
+    ~TilePyramid() { Clear(); }
+
+    void Reset(int imgW, int imgH) {
+        Clear();
+        width = imgW; height = imgH;
+        levels = 1;
+        while ((std::max(width, height) >> (levels - 1)) > kTileSize) ++levels;
+    }
+    void Clear() {
+        for (Tile& t : lru) DeleteObject(t.bm);
+        lru.clear();
+        index.clear();
+        stats.bytes = stats.tiles = 0;
+    }
+    void SetBudget(size_t bytes) { budget = bytes; Evict(0); }
+    const Stats& GetStats() const { return stats; }
+    int Levels() const { return levels; }
+
+    // finest level that is at most 2x larger than the target scale
+    int LevelFor(float scale) const {
+        int L = 0;
+        while (L + 1 < levels && scale <= 1.0f / (float)(2 << L)) ++L;
+        return L;
+    }
+    int LevelW(int L) const { return (width + (1 << L) - 1) >> L; }
+    int LevelH(int L) const { return (height + (1 << L) - 1) >> L; }
+
+    // draw the tiles intersecting `vis` (scaled-image pixels) of a w x h rendering at (x, y)
+    void Draw(HDC hdc, Gdiplus::Image* img, int x, int y, int w, int h, const RECT& vis, bool fast, bool opaque) {
+        int L = LevelFor(std::min((float)w / width, (float)h / height));
+        int lw = LevelW(L), lh = LevelH(L);
+        float fx = (float)w * (1 << L) / width, fy = (float)h * (1 << L) / height; // level px -> dest px
+        int ntx = (lw + kTileSize - 1) / kTileSize, nty = (lh + kTileSize - 1) / kTileSize;
+        int tx0 = std::clamp((int)(vis.left / fx) / kTileSize, 0, ntx - 1);
+        int tx1 = std::clamp((int)((vis.right - 1) / fx) / kTileSize, 0, ntx - 1);
+        int ty0 = std::clamp((int)(vis.top / fy) / kTileSize, 0, nty - 1);
+        int ty1 = std::clamp((int)((vis.bottom - 1) / fy) / kTileSize, 0, nty - 1);
+        // tile edges in dest pixels, shared by neighbours so there are no seams
+        auto edgeX = [&](int i) { return i * kTileSize >= lw ? x + w : x + (int)std::floor(i * kTileSize * fx); };
+        auto edgeY = [&](int i) { return i * kTileSize >= lh ? y + h : y + (int)std::floor(i * kTileSize * fy); };
+
+        HDC mdc = CreateCompatibleDC(hdc);
+        int oldMode = SetStretchBltMode(hdc, fast ? COLORONCOLOR : HALFTONE);
+        if (!fast) SetBrushOrgEx(hdc, 0, 0, nullptr);
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            for (int tx = tx0; tx <= tx1; ++tx) {
+                const Tile* t = Get(img, L, tx, ty);
+                if (!t) continue;
+                int dl = edgeX(tx), dr = edgeX(tx + 1), dt = edgeY(ty), db = edgeY(ty + 1);
+                HGDIOBJ prev = SelectObject(mdc, t->bm);
+                if (opaque) {
+                    StretchBlt(hdc, dl, dt, dr - dl, db - dt, mdc, 0, 0, t->w, t->h, SRCCOPY);
+                } else {
+                    BLENDFUNCTION bf{AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
+                    AlphaBlend(hdc, dl, dt, dr - dl, db - dt, mdc, 0, 0, t->w, t->h, bf);
+                }
+                SelectObject(mdc, prev); // a selected bitmap could not be evicted
+            }
+        }
+        SetStretchBltMode(hdc, oldMode);
+        DeleteDC(mdc);
+    }
+
+private:
+    struct Tile {
+        uint64_t key;
+        HBITMAP bm;
+        const uint32_t* px; // the DIB's PARGB pixels, w * h, top-down
+        int w, h;
+    };
+    int width = 0, height = 0, levels = 1;
+    size_t budget = 256u * 1024 * 1024;
+    std::list<Tile> lru; // most recently used first
+    std::unordered_map<uint64_t, std::list<Tile>::iterator> index;
+    Stats stats;
+
+    static uint64_t Key(int L, int tx, int ty) { return ((uint64_t)L << 48) | ((uint64_t)ty << 24) | (uint64_t)tx; }
+
+    const Tile* Get(Gdiplus::Image* img, int L, int tx, int ty) {
+        uint64_t key = Key(L, tx, ty);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            ++stats.hits;
+            lru.splice(lru.begin(), lru, it->second);
+            return &lru.front();
+        }
+        ++stats.misses;
+        int tw = std::min(kTileSize, LevelW(L) - tx * kTileSize);
+        int th = std::min(kTileSize, LevelH(L) - ty * kTileSize);
+        if (tw <= 0 || th <= 0) return nullptr;
+        size_t bytes = (size_t)tw * th * 4;
+
+        BITMAPINFO bmi{};
+        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bmi.bmiHeader.biWidth = tw;
+        bmi.bmiHeader.biHeight = -th;
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+        void* bits = nullptr;
+        HBITMAP bm = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+        if (!bm) return nullptr;
+        if (L == 0) {
+            Gdiplus::Bitmap target(tw, th, tw * 4, PixelFormat32bppPARGB, (BYTE*)bits);
+            Gdiplus::Graphics g(&target);
+            g.SetCompositingMode(CompositingModeSourceCopy);
+            g.SetInterpolationMode(InterpolationModeNearestNeighbor);
+            g.SetPixelOffsetMode(PixelOffsetModeHalf);
+            Gdiplus::ImageAttributes attr;
+            attr.SetWrapMode(WrapModeTileFlipXY);
+            float sx = (float)tx * kTileSize, sy = (float)ty * kTileSize;
+            g.DrawImage(img, Gdiplus::RectF(0, 0, (REAL)tw, (REAL)th), sx, sy, (REAL)tw, (REAL)th, UnitPixel, &attr);
+        } else {
+            Downsample(img, L, tx, ty, (uint32_t*)bits, tw, th);
+        }
+        Evict(bytes); // after the children, which may have been built (and evicted) on the way
+        lru.push_front(Tile{key, bm, (const uint32_t*)bits, tw, th});
+        index[key] = lru.begin();
+        stats.bytes += bytes;
+        ++stats.tiles;
+        return &lru.front();
+    }
+
+    // fill a level L tile by averaging 2x2 blocks of the four level L-1 tiles it covers.
+    // Each child is consumed before the next Get, which may evict it.
+    void Downsample(Gdiplus::Image* img, int L, int tx, int ty, uint32_t* out, int tw, int th) {
+        const int half = kTileSize / 2;
+        for (int cy = 0; cy < 2; ++cy) {
+            for (int cx = 0; cx < 2; ++cx) {
+                int ox0 = cx * half, oy0 = cy * half;
+                if (ox0 >= tw || oy0 >= th) continue; // past the edge of the level
+                const Tile* c = Get(img, L - 1, 2 * tx + cx, 2 * ty + cy);
+                if (!c) continue;
+                int ow = std::min(tw - ox0, (c->w + 1) / 2), oh = std::min(th - oy0, (c->h + 1) / 2);
+                for (int y = 0; y < oh; ++y) {
+                    // an odd child (only at the image's right/bottom edge) repeats its last row/column
+                    const uint32_t* r0 = c->px + (size_t)(2 * y) * c->w;
+                    const uint32_t* r1 = c->px + (size_t)std::min(2 * y + 1, c->h - 1) * c->w;
+                    uint32_t* d = out + (size_t)(oy0 + y) * tw + ox0;
+                    for (int x = 0; x < ow; ++x) {
+                        int x0 = 2 * x, x1 = std::min(2 * x + 1, c->w - 1);
+                        d[x] = Average4(r0[x0], r0[x1], r1[x0], r1[x1]);
+                    }
+                }
+            }
+        }
+    }
+    // per-channel mean of four premultiplied pixels, rounded
+    static uint32_t Average4(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        uint32_t out = 0;
+        for (int s = 0; s < 32; s += 8) {
+            uint32_t sum = ((a >> s) & 255) + ((b >> s) & 255) + ((c >> s) & 255) + ((d >> s) & 255);
+            out |= ((sum + 2) >> 2) << s;
+        }
+        return out;
+    }
+
+    // make room for `incoming` bytes
+    void Evict(size_t incoming) {
+        while (!lru.empty() && stats.bytes + incoming > budget) {
+            Tile& t = lru.back();
+            stats.bytes -= (size_t)t.w * t.h * 4;
+            --stats.tiles;
+            ++stats.evictions;
+            DeleteObject(t.bm);
+            index.erase(t.key);
+            lru.pop_back();
+        }
+    }
+};
+
+// -------------------- Decoding --------------------
+// Posted to the window given to LoadAsync; forward it to ImageRenderer::HandleAsyncMessage.
+constexpr UINT WM_IMGRND_ASYNC = WM_APP + 0x120;
+
+// A fully decoded image: owned 32bpp PARGB pixels, no file or stream kept open.
+// Safe to create on a worker thread and hand to the UI thread.
+struct DecodedImage {
+    std::shared_ptr<Gdiplus::Bitmap> bitmap;
+    int width = 0, height = 0;
+    bool opaque = true;
+    size_t Bytes() const { return (size_t)width * height * 4; }
+};
+
+// GDI+ polls this during DrawImage; returning TRUE aborts the decode
+inline BOOL CALLBACK AbortIfCancelled(VOID* flag) {
+    return static_cast<const std::atomic<bool>*>(flag)->load() ? TRUE : FALSE;
+}
+
+// decode everything now rather than lazily on first draw; a set *cancel stops it part way
+inline std::shared_ptr<Gdiplus::Bitmap> DecodeToPargb(Gdiplus::Image& src, const std::atomic<bool>* cancel = nullptr) {
+    INT w = (INT)src.GetWidth(), h = (INT)src.GetHeight();
+    if (w <= 0 || h <= 0) return nullptr;
+    auto out = std::make_shared<Gdiplus::Bitmap>(w, h, PixelFormat32bppPARGB);
+    if (out->GetLastStatus() != Gdiplus::Ok) return nullptr;
+    Gdiplus::Graphics g(out.get());
+    g.SetCompositingMode(CompositingModeSourceCopy);
+    Gdiplus::Status st = cancel
+        ? g.DrawImage(&src, Gdiplus::Rect(0, 0, w, h), 0, 0, w, h, UnitPixel, nullptr,
+                      AbortIfCancelled, const_cast<std::atomic<bool>*>(cancel))
+        : g.DrawImage(&src, 0, 0, w, h);
+    if (st != Gdiplus::Ok) return nullptr;
+    return out;
+}
+
+inline std::shared_ptr<DecodedImage> DecodeImage(Gdiplus::Image& src, const std::atomic<bool>* cancel = nullptr) {
+    if (src.GetLastStatus() != Gdiplus::Ok) return nullptr;
+    auto d = std::make_shared<DecodedImage>();
+    d->width = (int)src.GetWidth();
+    d->height = (int)src.GetHeight();
+    d->opaque = (src.GetFlags() & Gdiplus::ImageFlagsHasAlpha) == 0;
+    d->bitmap = DecodeToPargb(src, cancel);
+    return d->bitmap ? d : nullptr;
+}
+
+inline std::shared_ptr<DecodedImage> DecodeImageFile(const std::wstring& filePath) {
+    Gdiplus::Image src(filePath.c_str());
+    return DecodeImage(src);
+}
+
+// the EXIF thumbnail (usually a ~160x120 JPEG) embedded in camera images, if any
+inline std::shared_ptr<Gdiplus::Bitmap> LoadExifThumbnail(Gdiplus::Image& src) {
+    UINT size = src.GetPropertyItemSize(PropertyTagThumbnailData);
+    if (size == 0) return nullptr;
+    std::vector<BYTE> buf(size);
+    Gdiplus::PropertyItem* item = (Gdiplus::PropertyItem*)buf.data();
+    if (src.GetPropertyItem(PropertyTagThumbnailData, size, item) != Gdiplus::Ok || item->length == 0) return nullptr;
+    IStream* stream = SHCreateMemStream((const BYTE*)item->value, item->length);
+    if (!stream) return nullptr;
+    std::shared_ptr<Gdiplus::Bitmap> thumb;
+    {
+        Gdiplus::Bitmap encoded(stream);
+        if (encoded.GetLastStatus() == Gdiplus::Ok) thumb = DecodeToPargb(encoded);
+    }
+    stream->Release();
+    return thumb;
+}
+
+// -------------------- Prefetch cache --------------------
+// Decodes a prioritised list of files ahead of time on background threads and keeps the
+// results under a memory cap. Prefetch() replaces the wish list; entries that dropped off it
+// are evicted first (least recently used), then the lowest-priority wanted ones.
+class PrefetchCache {
+public:
+    struct Stats { size_t hits = 0, misses = 0, decoded = 0, evictions = 0, bytes = 0, entries = 0, joined = 0; };
+    using ReadyFn = std::function<void(const std::shared_ptr<DecodedImage>&)>;
+
+    explicit PrefetchCache(size_t budgetBytes = 512u * 1024 * 1024, int threads = 2) : budget(budgetBytes) {
+        for (int i = 0; i < std::max(1, threads); ++i) workers.emplace_back([this] { WorkerLoop(); });
+    }
+    PrefetchCache(const PrefetchCache&) = delete;
+    PrefetchCache& operator=(const PrefetchCache&) = delete;
+    ~PrefetchCache() {
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            stopping = true;
+            queue.clear();
+            waiters.clear();
+        }
+        cv.notify_all();
+        for (std::thread& t : workers) t.join();
+    }
+
+    // decoded image if cached; counts a hit or a miss
+    std::shared_ptr<DecodedImage> Get(const std::wstring& path) {
+        std::lock_guard<std::mutex> lk(mu);
+        auto it = entries.find(path);
+        if (it == entries.end()) { ++stats.misses; return nullptr; }
+        ++stats.hits;
+        it->second.lastUse = ++tick;
+        return it->second.image;
+    }
+
+    // Get(), except that when a worker is decoding path right now nothing is returned and
+    // onReady(image) is queued to run on that worker once it finishes (image is null if the
+    // decode failed), with waiting set. Saves starting a second decode of the same file.
+    // On a plain miss waiting is false and onReady is dropped.
+    std::shared_ptr<DecodedImage> GetOrWait(const std::wstring& path, ReadyFn onReady, bool& waiting) {
+        std::lock_guard<std::mutex> lk(mu);
+        waiting = false;
+        auto it = entries.find(path);
+        if (it != entries.end()) {
+            ++stats.hits;
+            it->second.lastUse = ++tick;
+            return it->second.image;
+        }
+        if (inflight.count(path)) {
+            ++stats.joined;
+            waiters[path].push_back(std::move(onReady));
+            waiting = true;
+            return nullptr;
+        }
+        ++stats.misses;
+        return nullptr;
+    }
+
+    // add an image decoded elsewhere (e.g. by ImageRenderer::LoadAsync after a miss)
+    void Put(const std::wstring& path, const std::shared_ptr<DecodedImage>& d) {
+        if (!d) return;
+        std::lock_guard<std::mutex> lk(mu);
+        Insert(path, d);
+    }
+
+    // files to decode, most wanted first; replaces any earlier list. `current` is kept at
+    // top priority without being queued, since whoever shows it decodes it on a miss.
+    void Prefetch(const std::vector<std::wstring>& paths, const std::wstring& current = L"") {
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            wanted.clear();
+            queue.clear();
+            if (!current.empty()) wanted.emplace(current, -1);
+            for (size_t i = 0; i < paths.size(); ++i) {
+                wanted.emplace(paths[i], (int)i);
+                if (!entries.count(paths[i]) && !inflight.count(paths[i])) queue.push_back(paths[i]);
+            }
+            for (auto& kv : entries) kv.second.rank = RankOf(kv.first);
+        }
+        cv.notify_all();
+    }
+
+    void SetBudget(size_t bytes) { std::lock_guard<std::mutex> lk(mu); budget = bytes; Evict(); }
+    void Clear() {
+        std::lock_guard<std::mutex> lk(mu);
+        entries.clear();
+        queue.clear();
+        wanted.clear();
+        stats.bytes = stats.entries = 0;
+    }
+    Stats GetStats() const { std::lock_guard<std::mutex> lk(mu); return stats; }
+
+private:
+    struct Entry {
+        std::shared_ptr<DecodedImage> image;
+        unsigned long long lastUse = 0;
+        int rank = INT_MAX; // position in the wish list, INT_MAX when not wanted
+    };
+
+    mutable std::mutex mu;
+    std::condition_variable cv;
+    std::vector<std::thread> workers;
+    std::deque<std::wstring> queue;
+    std::unordered_map<std::wstring, Entry> entries;
+    std::unordered_map<std::wstring, int> wanted;
+    std::unordered_set<std::wstring> inflight;
+    std::unordered_map<std::wstring, std::vector<ReadyFn>> waiters; // GetOrWait callers per in-flight path
+    size_t budget;
+    unsigned long long tick = 0;
+    bool stopping = false;
+    Stats stats;
+
+    int RankOf(const std::wstring& path) const {
+        auto it = wanted.find(path);
+        return it == wanted.end() ? INT_MAX : it->second;
+    }
+
+    void WorkerLoop() {
+        for (;;) {
+            std::wstring path;
+            {
+                std::unique_lock<std::mutex> lk(mu);
+                cv.wait(lk, [this] { return stopping || !queue.empty(); });
+                if (stopping) return;
+                path = std::move(queue.front());
+                queue.pop_front();
+                if (entries.count(path) || inflight.count(path)) continue;
+                inflight.insert(path);
+            }
+            std::shared_ptr<DecodedImage> d = DecodeImageFile(path);
+            std::vector<ReadyFn> ready;
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                inflight.erase(path);
+                // the wish list may have moved on while this was decoding
+                if (d && wanted.count(path)) { ++stats.decoded; Insert(path, d); }
+                auto w = waiters.find(path);
+                if (w != waiters.end()) { ready.swap(w->second); waiters.erase(w); }
+            }
+            for (ReadyFn& fn : ready) if (fn) fn(d); // outside the lock: callbacks may call back in
+        }
+    }
+
+    // caller holds mu
+    void Insert(const std::wstring& path, const std::shared_ptr<DecodedImage>& d) {
+        auto it = entries.find(path);
+        if (it != entries.end()) { stats.bytes -= it->second.image->Bytes(); --stats.entries; entries.erase(it); }
+        Entry& e = entries[path];
+        e.image = d;
+        e.lastUse = ++tick;
+        e.rank = RankOf(path);
+        stats.bytes += d->Bytes();
+        ++stats.entries;
+        Evict();
+    }
+
+    // caller holds mu
+    void Evict() {
+        while (stats.bytes > budget && !entries.empty()) {
+            auto victim = entries.begin();
+            for (auto it = entries.begin(); it != entries.end(); ++it) {
+                const Entry& a = it->second;
+                const Entry& v = victim->second;
+                if (a.rank > v.rank || (a.rank == v.rank && a.lastUse < v.lastUse)) victim = it;
+            }
+            stats.bytes -= victim->second.image->Bytes();
+            --stats.entries;
+            ++stats.evictions;
+            entries.erase(victim);
+        }
+    }
+};
+
+// -------------------- Render quality --------------------
+// Fast: nearest-neighbour, stretching the cached rendering when there is one.
+// High: bicubic. Auto: Fast between NotifyInteraction() and the idle repaint, High otherwise.
+enum class RenderQuality { Fast, High, Auto };
+
 // -------------------- Image class --------------------
 class ImageRenderer {
 private:
-    std::unique_ptr<Gdiplus::Image> image;
+    std::shared_ptr<Gdiplus::Image> image;
+    std::shared_ptr<Gdiplus::Image> preview; // shown stretched while an async load runs
+    std::shared_ptr<DecodedImage> decoded;   // set when the image came from SetImage/LoadAsync
     std::wstring path;
     bool valid = false;
+    bool opaque = true;
     int width = 0, height = 0;
+    ScaledCache cache;
+    std::unique_ptr<TilePyramid> pyramid; // optional, replaces the scaled cache when set
+    long long cacheBudget = 16 * 1024 * 1024; // pixels (4 bytes each)
+    bool interacting = false;
+    HWND idleHwnd = NULL;
+    UINT idleDelay = 150; // ms without interaction before the high-quality repaint
+
+    // one in-flight LoadAsync; the worker fills it in and posts WM_IMGRND_ASYNC
+    struct AsyncJob {
+        unsigned generation = 0;
+        HWND hwnd = NULL;
+        std::wstring path;
+        std::atomic<bool> cancelled{false};
+        std::mutex mu;
+        std::shared_ptr<Gdiplus::Bitmap> preview;
+        std::shared_ptr<DecodedImage> result;
+        int width = 0, height = 0;
+    };
+    enum : LPARAM { kAsyncPreview = 1, kAsyncDone = 2 };
+    std::shared_ptr<AsyncJob> job;
+    std::function<void(bool)> jobDone;
+
+    // LoadAsync decodes on one worker owned (and joined) by the renderer, so at most one decode
+    // runs at a time and none outlives GDI+. A load requested while another is still unwinding
+    // waits in `queued`; a newer request replaces it.
+    std::thread worker;
+    std::mutex workerMu;
+    std::condition_variable workerCv;
+    std::shared_ptr<AsyncJob> queued;
+    bool workerStop = false;
+
+    // unique across renderers, so several can share one window
+    static std::atomic<unsigned>& NextGeneration() { static std::atomic<unsigned> g{0}; return g; }
 
 public:
     ImageRenderer() = default;
+    ImageRenderer(const ImageRenderer&) = delete;
+    ImageRenderer& operator=(const ImageRenderer&) = delete;
+    ~ImageRenderer() {
+        if (idleHwnd) KillTimer(idleHwnd, (UINT_PTR)this);
+        CancelLoad();
+        {
+            std::lock_guard<std::mutex> lk(workerMu);
+            workerStop = true;
+        }
+        workerCv.notify_one();
+        if (worker.joinable()) worker.join();
+    }
 
     bool Load(const std::wstring& filePath) {
+        CancelLoad();
         path = filePath;
+        preview.reset();
+        decoded.reset();
+        cache.Invalidate();
         image.reset(new Gdiplus::Image(filePath.c_str()));
         if (image && image->GetLastStatus() == Gdiplus::Ok) {
             width = image->GetWidth();
             height = image->GetHeight();
+            opaque = (image->GetFlags() & Gdiplus::ImageFlagsHasAlpha) == 0;
             valid = true;
         } else {
             valid = false;
         }
+        if (pyramid) pyramid->Reset(width, height);
         return valid;
     }
 
+    // show an already decoded image (from DecodeImageFile or a prefetch cache)
+    void SetImage(const std::shared_ptr<DecodedImage>& d, const std::wstring& filePath = L"") {
+        CancelLoad();
+        path = filePath;
+        preview.reset();
+        cache.Invalidate();
+        decoded = d;
+        image = d ? d->bitmap : nullptr;
+        valid = image != nullptr;
+        width = valid ? d->width : 0;
+        height = valid ? d->height : 0;
+        opaque = valid ? d->opaque : true;
+        if (pyramid) pyramid->Reset(width, height);
+    }
+
+    // Decode on a worker thread. Progress comes back as WM_IMGRND_ASYNC posted to hwnd,
+    // which the window must pass to HandleAsyncMessage; the EXIF thumbnail, when present,
+    // is shown first. onDone runs on the UI thread. Another Load/LoadAsync cancels this one.
+    void LoadAsync(HWND hwnd, const std::wstring& filePath, std::function<void(bool ok)> onDone = nullptr) {
+        CancelLoad();
+        auto j = std::make_shared<AsyncJob>();
+        j->generation = ++NextGeneration();
+        j->hwnd = hwnd;
+        j->path = filePath;
+        job = j;
+        jobDone = std::move(onDone);
+        {
+            std::lock_guard<std::mutex> lk(workerMu);
+            queued = j;
+        }
+        if (!worker.joinable()) worker = std::thread([this] { WorkerLoop(); });
+        workerCv.notify_one();
+    }
+    // drops the current load; a decode in progress stops at GDI+'s next abort poll
+    void CancelLoad() {
+        if (job) {
+            job->cancelled = true;
+            std::lock_guard<std::mutex> lk(workerMu);
+            if (queued == job) queued.reset();
+            job.reset();
+        }
+        jobDone = nullptr;
+    }
+    bool IsLoading() const { return job != nullptr; }
+    const std::wstring& GetPath() const { return path; }
+    const std::shared_ptr<DecodedImage>& GetDecoded() const { return decoded; }
+
+    // returns false for messages from cancelled or foreign loads
+    bool HandleAsyncMessage(WPARAM wParam, LPARAM lParam) {
+        if (!job || (unsigned)wParam != job->generation) return false;
+        std::shared_ptr<AsyncJob> j = job;
+        if (lParam == kAsyncPreview) {
+            std::lock_guard<std::mutex> lk(j->mu);
+            path = j->path;
+            image.reset();
+            decoded.reset();
+            preview = j->preview;
+            width = j->width;
+            height = j->height;
+            opaque = true;
+            valid = preview != nullptr;
+            cache.Invalidate();
+            return true;
+        }
+        std::shared_ptr<DecodedImage> result;
+        {
+            std::lock_guard<std::mutex> lk(j->mu);
+            result = j->result;
+        }
+        std::function<void(bool)> done = std::move(jobDone);
+        SetImage(result, j->path); // also clears job
+        if (done) done(result != nullptr);
+        return true;
+    }
+
+    // Tiled mipmap rendering for very large images: draws touch only the visible tiles of
+    // the level nearest the zoom, and at most budgetBytes of tiles stay resident.
+    void EnablePyramid(bool on, size_t budgetBytes = 256u * 1024 * 1024) {
+        if (!on) { pyramid.reset(); return; }
+        if (!pyramid) {
+            pyramid.reset(new TilePyramid());
+            pyramid->Reset(width, height);
+        }
+        pyramid->SetBudget(budgetBytes);
+        cache.Release();
+    }
+    const TilePyramid* GetPyramid() const { return pyramid.get(); }
+
+    // largest cached area in pixels; 0 disables the cache
+    void SetCacheBudget(long long pixels) { cacheBudget = pixels; if (pixels <= 0) cache.Release(); }
+    void InvalidateCache() { cache.Invalidate(); }
+
+    // Call on every zoom/drag step. Auto draws stay Fast until no call has come for the
+    // idle delay; then hwnd is invalidated once so the next paint is high quality.
+    void NotifyInteraction(HWND hwnd) {
+        if (idleHwnd && idleHwnd != hwnd) KillTimer(idleHwnd, (UINT_PTR)this);
+        idleHwnd = hwnd;
+        interacting = true;
+        SetTimer(hwnd, (UINT_PTR)this, idleDelay, IdleTimerProc); // restarts the countdown
+    }
+    bool IsInteracting() const { return interacting; }
+    void SetIdleDelay(UINT ms) { idleDelay = ms; }
+
     bool IsValid() const { return valid; }
 
     int GetWidth() const { return width; }
     int GetHeight() const { return height; }
 
-    void Draw(HDC hdc, int x, int y, int w = -1, int h = -1, bool keepAspect = true) {
+    // Resamples only when the target size changes; pans at the same size reuse the cache
+    // and copy just the part of the image inside the DC's clip box.
+    void Draw(HDC hdc, int x, int y, int w = -1, int h = -1, bool keepAspect = true,
+              RenderQuality quality = RenderQuality::High) {
         if (!valid) return;
-
-        Graphics g(hdc);
-        g.SetInterpolationMode(InterpolationModeHighQualityBicubic);
-        g.SetSmoothingMode(SmoothingModeHighQuality);
+        if (quality == RenderQuality::Auto) quality = interacting ? RenderQuality::Fast : RenderQuality::High;
 
         if (w <= 0) w = width;
         if (h <= 0) h = height;
@@ -74,13 +729,166 @@ public:
             float ratio = std::min((float)w / width, (float)h / height);
             int nw = (int)(width * ratio);
             int nh = (int)(height * ratio);
-            int cx = x + (w - nw) / 2;
-            int cy = y + (h - nh) / 2;
-            g.DrawImage(image.get(), cx, cy, nw, nh);
+            x += (w - nw) / 2;
+            y += (h - nh) / 2;
+            w = nw;
+            h = nh;
+        }
+        if (w <= 0 || h <= 0) return;
+
+        // visible part of the scaled image
+        RECT vis{0, 0, w, h};
+        RECT clip;
+        if (GetClipBox(hdc, &clip) != ERROR) {
+            OffsetRect(&clip, -x, -y);
+            if (!IntersectRect(&vis, &vis, &clip)) return;
+        }
+
+        if (!image) { DrawPreview(hdc, x, y, w, h); return; }
+
+        if (pyramid) {
+            pyramid->Draw(hdc, image.get(), x, y, w, h, vis, quality == RenderQuality::Fast, opaque);
+            return;
+        }
+
+        if (!cache.Covers(w, h, vis)) {
+            if (quality == RenderQuality::Fast) { DrawFast(hdc, x, y, w, h, vis); return; }
+            if (!RenderCache(w, h, vis)) { DrawDirect(hdc, x, y, w, h); return; }
+        }
+        int vw = vis.right - vis.left, vh = vis.bottom - vis.top;
+        int sx = vis.left - cache.part.left, sy = vis.top - cache.part.top;
+        if (opaque) {
+            BitBlt(hdc, x + vis.left, y + vis.top, vw, vh, cache.dc, sx, sy, SRCCOPY);
         } else {
-            g.DrawImage(image.get(), x, y, w, h);
+            BLENDFUNCTION bf{AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
+            AlphaBlend(hdc, x + vis.left, y + vis.top, vw, vh, cache.dc, sx, sy, vw, vh, bf);
         }
     }
+
+private:
+    void WorkerLoop() {
+        for (;;) {
+            std::shared_ptr<AsyncJob> j;
+            {
+                std::unique_lock<std::mutex> lk(workerMu);
+                workerCv.wait(lk, [this] { return workerStop || queued != nullptr; });
+                if (workerStop) return;
+                j = std::move(queued);
+            }
+            if (!j->cancelled) RunJob(*j, j->hwnd);
+        }
+    }
+
+    static void RunJob(AsyncJob& j, HWND hwnd) {
+        Gdiplus::Image src(j.path.c_str());
+        if (src.GetLastStatus() == Gdiplus::Ok && !j.cancelled) {
+            std::shared_ptr<Gdiplus::Bitmap> thumb = LoadExifThumbnail(src);
+            if (thumb) {
+                {
+                    std::lock_guard<std::mutex> lk(j.mu);
+                    j.preview = thumb;
+                    j.width = (int)src.GetWidth();
+                    j.height = (int)src.GetHeight();
+                }
+                PostMessage(hwnd, WM_IMGRND_ASYNC, j.generation, kAsyncPreview);
+            }
+        }
+        if (j.cancelled) return;
+        std::shared_ptr<DecodedImage> result = DecodeImage(src, &j.cancelled);
+        if (j.cancelled) return;
+        {
+            std::lock_guard<std::mutex> lk(j.mu);
+            j.result = result;
+        }
+        PostMessage(hwnd, WM_IMGRND_ASYNC, j.generation, kAsyncDone);
+    }
+
+    void DrawPreview(HDC hdc, int x, int y, int w, int h) {
+        if (!preview) return;
+        Graphics g(hdc);
+        g.SetInterpolationMode(InterpolationModeBilinear);
+        g.DrawImage(preview.get(), x, y, w, h);
+    }
+
+    static void CALLBACK IdleTimerProc(HWND hwnd, UINT, UINT_PTR id, DWORD) {
+        KillTimer(hwnd, id);
+        ImageRenderer* self = reinterpret_cast<ImageRenderer*>(id);
+        self->interacting = false;
+        self->idleHwnd = NULL;
+        InvalidateRect(hwnd, nullptr, FALSE);
+    }
+
+    // cheap draw of the visible part: stretch the cached rendering if it covers `vis`
+    // at its own scale, otherwise nearest-neighbour from the source
+    void DrawFast(HDC hdc, int x, int y, int w, int h, const RECT& vis) {
+        if (cache.targetW > 0 && cache.targetH > 0) {
+            float kx = (float)cache.targetW / w, ky = (float)cache.targetH / h;
+            int l = (int)(vis.left * kx), t = (int)(vis.top * ky);
+            int r = (int)std::ceil(vis.right * kx), b = (int)std::ceil(vis.bottom * ky);
+            if (l >= cache.part.left && t >= cache.part.top && r <= cache.part.right && b <= cache.part.bottom) {
+                // map the source rect back so the stretch lands exactly on the scaled image
+                int dl = x + (int)(l / kx), dt = y + (int)(t / ky);
+                int dr = x + (int)std::ceil(r / kx), db = y + (int)std::ceil(b / ky);
+                int sl = l - cache.part.left, st = t - cache.part.top;
+                if (opaque) {
+                    int oldMode = SetStretchBltMode(hdc, COLORONCOLOR);
+                    StretchBlt(hdc, dl, dt, dr - dl, db - dt, cache.dc, sl, st, r - l, b - t, SRCCOPY);
+                    SetStretchBltMode(hdc, oldMode);
+                } else {
+                    BLENDFUNCTION bf{AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
+                    AlphaBlend(hdc, dl, dt, dr - dl, db - dt, cache.dc, sl, st, r - l, b - t, bf);
+                }
+                return;
+            }
+        }
+        Graphics g(hdc);
+        g.SetInterpolationMode(InterpolationModeNearestNeighbor);
+        g.SetPixelOffsetMode(PixelOffsetModeHalf);
+        float sx = (float)width / w, sy = (float)height / h;
+        int vw = vis.right - vis.left, vh = vis.bottom - vis.top;
+        g.DrawImage(image.get(), Gdiplus::RectF((REAL)(x + vis.left), (REAL)(y + vis.top), (REAL)vw, (REAL)vh),
+                    vis.left * sx, vis.top * sy, vw * sx, vh * sy, UnitPixel);
+    }
+
+    void DrawDirect(HDC hdc, int x, int y, int w, int h) {
+        Graphics g(hdc);
+        g.SetInterpolationMode(InterpolationModeHighQualityBicubic);
+        g.SetSmoothingMode(SmoothingModeHighQuality);
+        g.DrawImage(image.get(), x, y, w, h);
+    }
+
+    // resample the part of a w x h rendering around `vis` into the cache
+    bool RenderCache(int w, int h, const RECT& vis) {
+        if (cacheBudget <= 0) return false;
+        RECT part{0, 0, w, h};
+        if ((long long)w * h > cacheBudget) {
+            // half a view of margin on each side keeps short pans inside the cache
+            int mx = (vis.right - vis.left) / 2, my = (vis.bottom - vis.top) / 2;
+            RECT want{vis.left - mx, vis.top - my, vis.right + mx, vis.bottom + my};
+            IntersectRect(&part, &part, &want);
+            if ((long long)(part.right - part.left) * (part.bottom - part.top) > cacheBudget) part = vis;
+            if ((long long)(part.right - part.left) * (part.bottom - part.top) > cacheBudget) return false;
+        }
+        int pw = part.right - part.left, ph = part.bottom - part.top;
+        if (!cache.Reserve(pw, ph)) return false;
+
+        GdiFlush();
+        Gdiplus::Bitmap target(pw, ph, cache.capW * 4, PixelFormat32bppPARGB, (BYTE*)cache.bits);
+        Gdiplus::Graphics g(&target);
+        g.SetCompositingMode(CompositingModeSourceCopy);
+        g.SetInterpolationMode(InterpolationModeHighQualityBicubic);
+        g.SetPixelOffsetMode(PixelOffsetModeHighQuality);
+        Gdiplus::ImageAttributes attr;
+        attr.SetWrapMode(WrapModeTileFlipXY); // no dark fringe along the cached area's edges
+        float sx = (float)width / w, sy = (float)height / h;
+        g.DrawImage(image.get(), Gdiplus::RectF(0, 0, (REAL)pw, (REAL)ph),
+                    part.left * sx, part.top * sy, pw * sx, ph * sy, UnitPixel, &attr);
+
+        cache.targetW = w;
+        cache.targetH = h;
+        cache.part = part;
+        return true;
+    }
 };
 
 // -------------------- Utility Function --------------------
@@ -0,0 +1,267 @@
+// softgui_raster.hpp — 32-bit pixel kernels for SoftGUI canvases
+// Scalar, SSE2 and AVX2 paths for span fill and alpha blending, picked once at runtime
+// from the CPU's features. Works on plain BGRA32 memory (no Windows headers needed).
+
+#ifndef SOFTGUI_RASTER_HPP
+#define SOFTGUI_RASTER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define SOFTGUI_RASTER_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define SOFTGUI_TARGET(isa)
+    #else
+        #define SOFTGUI_TARGET(isa) __attribute__((target(isa)))
+    #endif
+#endif
+
+namespace SoftGUI {
+namespace raster {
+
+// view over BGRA32 pixels; stride is in pixels
+struct Surface {
+    uint32_t *px = nullptr;
+    int w = 0, h = 0, stride = 0;
+    uint32_t* row(int y) const { return px + (size_t)y * stride; }
+};
+
+enum class Isa { Scalar, SSE2, AVX2 };
+
+// ---------- Scalar kernels ----------
+inline void fill_span_scalar(uint32_t *dst, size_t n, uint32_t v) {
+    for (size_t i = 0; i < n; ++i) dst[i] = v;
+}
+
+// (s*a + d*(255-a)) / 255 rounded once, matching the SIMD lanes bit for bit
+inline uint32_t lerp255(uint32_t s, uint32_t d, uint32_t a) {
+    uint32_t t = s * a + d * (255 - a) + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// straight-alpha source over destination; the result keeps the destination alpha
+inline void blend_span_scalar(uint32_t *dst, const uint32_t *src, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t s = src[i], a = s >> 24;
+        if (a == 0) continue;
+        uint32_t d = dst[i];
+        if (a == 255) { dst[i] = (d & 0xFF000000u) | (s & 0x00FFFFFFu); continue; }
+        uint32_t b = lerp255(s & 0xFF, d & 0xFF, a);
+        uint32_t g = lerp255((s >> 8) & 0xFF, (d >> 8) & 0xFF, a);
+        uint32_t r = lerp255((s >> 16) & 0xFF, (d >> 16) & 0xFF, a);
+        dst[i] = (d & 0xFF000000u) | (r << 16) | (g << 8) | b;
+    }
+}
+
+#ifdef SOFTGUI_RASTER_X86
+// ---------- SSE2 kernels ----------
+SOFTGUI_TARGET("sse2")
+inline void fill_span_sse2(uint32_t *dst, size_t n, uint32_t v) {
+    __m128i vv = _mm_set1_epi32((int)v);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm_storeu_si128((__m128i*)(dst + i), vv);
+        _mm_storeu_si128((__m128i*)(dst + i + 4), vv);
+        _mm_storeu_si128((__m128i*)(dst + i + 8), vv);
+        _mm_storeu_si128((__m128i*)(dst + i + 12), vv);
+    }
+    for (; i + 4 <= n; i += 4) _mm_storeu_si128((__m128i*)(dst + i), vv);
+    fill_span_scalar(dst + i, n - i, v);
+}
+
+// blends two pixels held as 16-bit lanes: (s*a + d*(255-a)) / 255
+SOFTGUI_TARGET("sse2")
+inline __m128i blend_lanes_sse2(__m128i s16, __m128i d16, __m128i a16) {
+    const __m128i k255 = _mm_set1_epi16(255), k128 = _mm_set1_epi16(128);
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(s16, a16), _mm_mullo_epi16(d16, _mm_sub_epi16(k255, a16)));
+    t = _mm_add_epi16(t, k128);
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// broadcast each pixel's alpha into its four 16-bit lanes
+SOFTGUI_TARGET("sse2")
+inline __m128i alpha_lanes_sse2(__m128i p16) {
+    __m128i a = _mm_shufflelo_epi16(p16, _MM_SHUFFLE(3,3,3,3));
+    return _mm_shufflehi_epi16(a, _MM_SHUFFLE(3,3,3,3));
+}
+
+SOFTGUI_TARGET("sse2")
+inline void blend_span_sse2(uint32_t *dst, const uint32_t *src, size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i dst_alpha = _mm_set1_epi32((int)0xFF000000u);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i slo = _mm_unpacklo_epi8(s, zero), shi = _mm_unpackhi_epi8(s, zero);
+        __m128i dlo = _mm_unpacklo_epi8(d, zero), dhi = _mm_unpackhi_epi8(d, zero);
+        __m128i lo = blend_lanes_sse2(slo, dlo, alpha_lanes_sse2(slo));
+        __m128i hi = blend_lanes_sse2(shi, dhi, alpha_lanes_sse2(shi));
+        __m128i out = _mm_packus_epi16(lo, hi);
+        // keep the destination alpha, as the scalar path does
+        out = _mm_or_si128(_mm_andnot_si128(dst_alpha, out), _mm_and_si128(dst_alpha, d));
+        _mm_storeu_si128((__m128i*)(dst + i), out);
+    }
+    blend_span_scalar(dst + i, src + i, n - i);
+}
+
+// ---------- AVX2 kernels ----------
+SOFTGUI_TARGET("avx2")
+inline void fill_span_avx2(uint32_t *dst, size_t n, uint32_t v) {
+    __m256i vv = _mm256_set1_epi32((int)v);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        _mm256_storeu_si256((__m256i*)(dst + i), vv);
+        _mm256_storeu_si256((__m256i*)(dst + i + 8), vv);
+        _mm256_storeu_si256((__m256i*)(dst + i + 16), vv);
+        _mm256_storeu_si256((__m256i*)(dst + i + 24), vv);
+    }
+    for (; i + 8 <= n; i += 8) _mm256_storeu_si256((__m256i*)(dst + i), vv);
+    fill_span_scalar(dst + i, n - i, v);
+}
+
+SOFTGUI_TARGET("avx2")
+inline __m256i blend_lanes_avx2(__m256i s16, __m256i d16) {
+    const __m256i k255 = _mm256_set1_epi16(255), k128 = _mm256_set1_epi16(128);
+    // alpha of each pixel in all four of its lanes
+    const __m256i amask = _mm256_setr_epi8(6,7,6,7,6,7,6,7, 14,15,14,15,14,15,14,15,
+                                           6,7,6,7,6,7,6,7, 14,15,14,15,14,15,14,15);
+    __m256i a16 = _mm256_shuffle_epi8(s16, amask);
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(s16, a16), _mm256_mullo_epi16(d16, _mm256_sub_epi16(k255, a16)));
+    t = _mm256_add_epi16(t, k128);
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+SOFTGUI_TARGET("avx2")
+inline void blend_span_avx2(uint32_t *dst, const uint32_t *src, size_t n) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i dst_alpha = _mm256_set1_epi32((int)0xFF000000u);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        // unpack stays within 128-bit halves, and so does the pack below: pixel order is preserved
+        __m256i lo = blend_lanes_avx2(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero));
+        __m256i hi = blend_lanes_avx2(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero));
+        __m256i out = _mm256_packus_epi16(lo, hi);
+        out = _mm256_or_si256(_mm256_andnot_si256(dst_alpha, out), _mm256_and_si256(dst_alpha, d));
+        _mm256_storeu_si256((__m256i*)(dst + i), out);
+    }
+    blend_span_sse2(dst + i, src + i, n - i);
+}
+#endif // SOFTGUI_RASTER_X86
+
+// ---------- Runtime dispatch ----------
+inline Isa detect_isa() {
+#ifdef SOFTGUI_RASTER_X86
+  #if defined(_MSC_VER) && !defined(__clang__)
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] >= 7) {
+        __cpuid(r, 1);
+        bool osxsave = (r[2] & (1 << 27)) != 0, avx = (r[2] & (1 << 28)) != 0;
+        if (osxsave && avx && (_xgetbv(0) & 6) == 6) {
+            __cpuidex(r, 7, 0);
+            if (r[1] & (1 << 5)) return Isa::AVX2;
+        }
+    }
+    return Isa::SSE2;
+  #else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Isa::AVX2;
+    if (__builtin_cpu_supports("sse2")) return Isa::SSE2;
+  #endif
+#endif
+    return Isa::Scalar;
+}
+
+struct Kernels {
+    Isa isa = Isa::Scalar;
+    void (*fill_span)(uint32_t*, size_t, uint32_t) = fill_span_scalar;
+    void (*blend_span)(uint32_t*, const uint32_t*, size_t) = blend_span_scalar;
+};
+
+// select a path; requests above what the CPU supports fall back to the best available one
+inline Kernels make_kernels(Isa want) {
+    Kernels k;
+    Isa best = detect_isa();
+    if ((int)want > (int)best) want = best;
+#ifdef SOFTGUI_RASTER_X86
+    if (want == Isa::AVX2) { k.isa = want; k.fill_span = fill_span_avx2; k.blend_span = blend_span_avx2; }
+    else if (want == Isa::SSE2) { k.isa = want; k.fill_span = fill_span_sse2; k.blend_span = blend_span_sse2; }
+#endif
+    return k;
+}
+
+inline Kernels& kernels() { static Kernels k = make_kernels(Isa::AVX2); return k; }
+inline void set_isa(Isa isa) { kernels() = make_kernels(isa); }   // mainly for benchmarks
+inline const char* isa_name(Isa isa) { return isa == Isa::AVX2 ? "AVX2" : isa == Isa::SSE2 ? "SSE2" : "scalar"; }
+
+// ---------- Primitives (all clipped to the surface) ----------
+inline void fill_rect(const Surface &s, int x, int y, int w, int h, uint32_t v) {
+    int x0 = std::max(0, x), y0 = std::max(0, y);
+    int x1 = std::min(s.w, x + w), y1 = std::min(s.h, y + h);
+    if (x0 >= x1 || y0 >= y1) return;
+    auto fill = kernels().fill_span;
+    if (s.stride == s.w && x0 == 0 && x1 == s.w) { fill(s.row(y0), (size_t)s.w * (y1 - y0), v); return; }
+    for (int yy = y0; yy < y1; ++yy) fill(s.row(yy) + x0, (size_t)(x1 - x0), v);
+}
+
+inline void clear(const Surface &s, uint32_t v) { fill_rect(s, 0, 0, s.w, s.h, v); }
+
+// alpha-blend a straight-alpha BGRA sprite at (dx, dy)
+inline void blend(const Surface &dst, const Surface &src, int dx, int dy) {
+    int sx0 = std::max(0, -dx), sy0 = std::max(0, -dy);
+    int w = std::min(src.w, dst.w - dx) - sx0;
+    int h = std::min(src.h, dst.h - dy) - sy0;
+    if (w <= 0 || h <= 0) return;
+    auto bl = kernels().blend_span;
+    for (int yy = 0; yy < h; ++yy)
+        bl(dst.row(dy + sy0 + yy) + dx + sx0, src.row(sy0 + yy) + sx0, (size_t)w);
+}
+
+// 1-pixel line; horizontal runs go through the span kernel
+inline void line(const Surface &s, int x0, int y0, int x1, int y1, uint32_t v) {
+    if (y0 == y1) {
+        if (x0 > x1) std::swap(x0, x1);
+        fill_rect(s, x0, y0, x1 - x0 + 1, 1, v);
+        return;
+    }
+    if (x0 == x1) {
+        if (y0 > y1) std::swap(y0, y1);
+        if (x0 < 0 || x0 >= s.w) return;
+        for (int y = std::max(0, y0); y <= std::min(s.h - 1, y1); ++y) s.row(y)[x0] = v;
+        return;
+    }
+    // Bresenham
+    int dx = std::abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -std::abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    for (;;) {
+        if (x0 >= 0 && y0 >= 0 && x0 < s.w && y0 < s.h) s.row(y0)[x0] = v;
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+}
+
+// 1-pixel rectangle outline
+inline void rect(const Surface &s, int x, int y, int w, int h, uint32_t v) {
+    if (w <= 0 || h <= 0) return;
+    fill_rect(s, x, y, w, 1, v);
+    fill_rect(s, x, y + h - 1, w, 1, v);
+    if (h <= 2) return;
+    line(s, x, y + 1, x, y + h - 2, v);
+    line(s, x + w - 1, y + 1, x + w - 1, y + h - 2, v);
+}
+
+} // namespace raster
+} // namespace SoftGUI
+
+#endif // SOFTGUI_RASTER_HPP
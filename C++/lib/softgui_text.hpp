@@ -0,0 +1,338 @@
+// softgui_text.hpp — Piece-table text buffer for SoftGUI
+// Text is a sequence of pieces pointing into append-only storage, kept in a persistent
+// treap: edits are O(log n), copies are O(1) snapshots that share structure, and the text
+// can be walked or written out chunk by chunk without building one big string.
+// Edit a buffer from one thread at a time; snapshots may be read from any thread.
+// TextFinder searches contiguous text or a TextBuffer, including matches across pieces.
+
+#ifndef SOFTGUI_TEXT_HPP
+#define SOFTGUI_TEXT_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <utility>
+#include <algorithm>
+
+namespace SoftGUI {
+
+class TextBuffer {
+public:
+    TextBuffer() : store_(std::make_shared<Store>()) {}
+    // owns a copy of the initial text
+    explicit TextBuffer(std::string text) : TextBuffer() {
+        store_->original = std::make_shared<const std::string>(std::move(text));
+        if (!store_->original->empty()) root_ = leaf(store_->original->data(), store_->original->size());
+    }
+    // non-owning: `external` (e.g. a mapped file) must outlive the buffer and its snapshots
+    static TextBuffer view(std::string_view external) {
+        TextBuffer b;
+        if (!external.empty()) b.root_ = b.leaf(external.data(), external.size());
+        return b;
+    }
+
+    size_t size() const { return len(root_); }
+    bool empty() const { return !root_; }
+    size_t piece_count() const { return count(root_); }
+
+    // an independent version sharing all text and structure; later edits to either side
+    // do not affect the other
+    TextBuffer snapshot() const { return *this; }
+
+    void insert(size_t pos, std::string_view s) {
+        if (s.empty()) return;
+        if (pos > size()) pos = size();
+        const char *p = store_->append(s);
+        auto [l, r] = split(root_, pos);
+        // typing usually continues the previous insert: grow that piece instead of adding one
+        if (l && last_end(l) == p) l = extend_last(l, s.size());
+        else l = merge(l, leaf(p, s.size()));
+        root_ = merge(l, r);
+    }
+    void erase(size_t pos, size_t n) {
+        size_t sz = size();
+        if (pos >= sz || n == 0) return;
+        if (n > sz - pos) n = sz - pos;
+        auto [l, rest] = split(root_, pos);
+        auto [mid, r] = split(rest, n);
+        (void)mid;
+        root_ = merge(l, r);
+    }
+    void replace(size_t pos, size_t n, std::string_view s) { erase(pos, n); insert(pos, s); }
+    void append(std::string_view s) { insert(size(), s); }
+    void clear() { root_.reset(); }
+
+    char at(size_t pos) const {
+        const Node *t = root_.get();
+        while (t) {
+            size_t ll = len(t->left);
+            if (pos < ll) { t = t->left.get(); continue; }
+            pos -= ll;
+            if (pos < t->n) return t->p[pos];
+            pos -= t->n;
+            t = t->right.get();
+        }
+        return '\0';
+    }
+
+    // f(std::string_view) for each piece, in order
+    template <class F> void for_each_chunk(F &&f) const { walk(root_.get(), f); }
+    // same, limited to [pos, pos + n)
+    template <class F> void for_each_chunk(size_t pos, size_t n, F &&f) const {
+        walk_range(root_.get(), pos, n, f);
+    }
+
+    std::string substr(size_t pos, size_t n) const {
+        std::string out;
+        if (pos >= size()) return out;
+        out.reserve(std::min(n, size() - pos));
+        for_each_chunk(pos, n, [&](std::string_view c) { out.append(c.data(), c.size()); });
+        return out;
+    }
+    std::string str() const { return substr(0, size()); }
+
+    bool write_to(std::ostream &os) const {
+        for_each_chunk([&](std::string_view c) { os.write(c.data(), (std::streamsize)c.size()); });
+        return (bool)os;
+    }
+    bool write_to(FILE *f) const {
+        bool ok = true;
+        for_each_chunk([&](std::string_view c) { if (ok && fwrite(c.data(), 1, c.size(), f) != c.size()) ok = false; });
+        return ok;
+    }
+
+private:
+    // ---- append-only storage shared by a buffer and its snapshots ----
+    struct Store {
+        static constexpr size_t kChunk = 64 * 1024;
+        std::shared_ptr<const std::string> original;
+        std::vector<std::unique_ptr<char[]>> chunks; // never freed or moved while the store lives
+        size_t used = 0, cap = 0;
+        uint64_t seed = 0x9E3779B97F4A7C15ull;
+
+        const char *append(std::string_view s) {
+            if (chunks.empty() || cap - used < s.size()) {
+                cap = std::max(kChunk, s.size());
+                chunks.emplace_back(new char[cap]);
+                used = 0;
+            }
+            char *p = chunks.back().get() + used;
+            memcpy(p, s.data(), s.size());
+            used += s.size();
+            return p;
+        }
+        uint32_t priority() { // splitmix64
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return (uint32_t)(z ^ (z >> 31));
+        }
+    };
+
+    // ---- immutable treap node: one piece plus subtree totals ----
+    struct Node;
+    using Ptr = std::shared_ptr<const Node>;
+    struct Node {
+        const char *p;
+        size_t n;      // piece length
+        size_t total;  // length of the whole subtree
+        size_t pieces; // pieces in the subtree
+        uint32_t prio;
+        Ptr left, right;
+    };
+
+    std::shared_ptr<Store> store_;
+    Ptr root_;
+
+    static size_t len(const Ptr &t) { return t ? t->total : 0; }
+    static size_t count(const Ptr &t) { return t ? t->pieces : 0; }
+
+    static Ptr make(const char *p, size_t n, uint32_t prio, Ptr l, Ptr r) {
+        auto t = std::make_shared<Node>();
+        t->p = p; t->n = n; t->prio = prio;
+        t->total = len(l) + n + len(r);
+        t->pieces = count(l) + 1 + count(r);
+        t->left = std::move(l); t->right = std::move(r);
+        return t;
+    }
+    Ptr leaf(const char *p, size_t n) { return make(p, n, store_->priority(), nullptr, nullptr); }
+
+    // (first pos chars, the rest); a piece straddling pos is cut in two
+    std::pair<Ptr, Ptr> split(const Ptr &t, size_t pos) {
+        if (!t) return {nullptr, nullptr};
+        size_t ll = len(t->left);
+        if (pos <= ll) {
+            auto [a, b] = split(t->left, pos);
+            return {a, make(t->p, t->n, t->prio, b, t->right)};
+        }
+        if (pos >= ll + t->n) {
+            auto [a, b] = split(t->right, pos - ll - t->n);
+            return {make(t->p, t->n, t->prio, t->left, a), b};
+        }
+        size_t k = pos - ll;
+        Ptr a = merge(t->left, leaf(t->p, k));
+        Ptr b = merge(leaf(t->p + k, t->n - k), t->right);
+        return {a, b};
+    }
+    static Ptr merge(const Ptr &a, const Ptr &b) {
+        if (!a) return b;
+        if (!b) return a;
+        if (a->prio > b->prio) return make(a->p, a->n, a->prio, a->left, merge(a->right, b));
+        return make(b->p, b->n, b->prio, merge(a, b->left), b->right);
+    }
+
+    static const char *last_end(const Ptr &t) {
+        const Node *x = t.get();
+        while (x->right) x = x->right.get();
+        return x->p + x->n;
+    }
+    // copy of t with its last piece grown by extra chars (path copy down the right spine)
+    static Ptr extend_last(const Ptr &t, size_t extra) {
+        if (t->right) return make(t->p, t->n, t->prio, t->left, extend_last(t->right, extra));
+        return make(t->p, t->n + extra, t->prio, t->left, nullptr);
+    }
+
+    template <class F> static void walk(const Node *t, F &f) {
+        while (t) {
+            walk(t->left.get(), f);
+            f(std::string_view(t->p, t->n));
+            t = t->right.get(); // iterate down the right spine
+        }
+    }
+    template <class F> static void walk_range(const Node *t, size_t pos, size_t n, F &f) {
+        while (t && n) {
+            size_t ll = len(t->left);
+            if (pos < ll) {
+                size_t take = std::min(n, ll - pos);
+                walk_range(t->left.get(), pos, take, f);
+                n -= take;
+                pos = ll;
+            }
+            if (!n) return;
+            size_t off = pos - ll;
+            if (off < t->n) {
+                size_t take = std::min(n, t->n - off);
+                f(std::string_view(t->p + off, take));
+                n -= take;
+                off += take;
+            }
+            pos = off - t->n;
+            t = t->right.get();
+        }
+    }
+};
+
+// ---------- Substring search ----------
+// Case-sensitive search scans for the needle's first byte with memchr (vectorised in every
+// mainstream libc) and verifies with memcmp; case-insensitive search is Horspool over
+// ASCII-folded bytes. Matches are reported left to right and never overlap.
+class TextFinder {
+public:
+    static constexpr size_t npos = (size_t)-1;
+
+    explicit TextFinder(std::string_view needle, bool match_case = true)
+        : needle_(needle), match_case_(match_case) {
+        if (match_case_ || needle_.empty()) return;
+        for (char &c : needle_) c = fold(c);
+        size_t m = needle_.size();
+        for (size_t &s : skip_) s = m;
+        for (size_t k = 0; k + 1 < m; ++k) skip_[(unsigned char)needle_[k]] = m - 1 - k;
+    }
+
+    size_t size() const { return needle_.size(); }
+
+    // first match starting in [from, n - size()], or npos
+    size_t find(const char *p, size_t n, size_t from = 0) const {
+        size_t m = needle_.size();
+        if (m == 0 || n < m || from > n - m) return npos;
+        if (match_case_) {
+            const char *s = p + from, *last = p + n - m;
+            while (s <= last) {
+                s = (const char *)memchr(s, needle_[0], (size_t)(last - s) + 1);
+                if (!s) return npos;
+                if (memcmp(s + 1, needle_.data() + 1, m - 1) == 0) return (size_t)(s - p);
+                ++s;
+            }
+            return npos;
+        }
+        for (size_t i = from; i + m <= n; i += skip_[(unsigned char)fold(p[i + m - 1])]) {
+            size_t j = m;
+            while (j > 0 && fold(p[i + j - 1]) == needle_[j - 1]) --j;
+            if (j == 0) return i;
+        }
+        return npos;
+    }
+
+    // Every match at or after `from`. on_match(pos) returns false to stop; keep_going(pos)
+    // is polled between 4 MB slices so scans without hits can still be cancelled.
+    template <class OnMatch, class KeepGoing>
+    void find_all(const TextBuffer &buf, size_t from, OnMatch &&on_match, KeepGoing &&keep_going) const {
+        const size_t m = needle_.size();
+        if (m == 0) return;
+        const size_t kSlice = 4u << 20;
+        std::string carry;      // up to m - 1 bytes before the current piece
+        std::string seam;
+        size_t base = 0;        // absolute offset of the current piece
+        size_t next = from;     // earliest start allowed (no overlaps, nothing before `from`)
+        bool stop = false;
+        buf.for_each_chunk([&](std::string_view c) {
+            if (stop) return;
+            // matches that begin in earlier pieces and end in this one
+            if (!carry.empty()) {
+                seam.assign(carry);
+                seam.append(c.data(), std::min(c.size(), m - 1));
+                size_t carry_pos = base - carry.size();
+                for (size_t i = 0; (i = find(seam.data(), seam.size(), i)) != npos && i < carry.size(); ) {
+                    if (carry_pos + i >= next) {
+                        if (!on_match(carry_pos + i)) { stop = true; return; }
+                        next = carry_pos + i + m;
+                        i += m;
+                    } else {
+                        ++i;
+                    }
+                }
+            }
+            // matches inside this piece, a slice at a time
+            size_t i = next > base ? next - base : 0;
+            while (i + m <= c.size()) {
+                size_t slice_end = std::min(c.size(), i + kSlice);
+                size_t hit = find(c.data(), std::min(c.size(), slice_end + m - 1), i);
+                if (hit == npos || hit >= slice_end) {
+                    i = slice_end;
+                    if (!keep_going(base + i)) { stop = true; return; }
+                    continue;
+                }
+                if (!on_match(base + hit)) { stop = true; return; }
+                next = base + hit + m;
+                i = hit + m;
+            }
+            // the last m - 1 bytes seen so far start the next seam
+            if (m > 1) {
+                carry.append(c.data() + c.size() - std::min(c.size(), m - 1), std::min(c.size(), m - 1));
+                if (carry.size() > m - 1) carry.erase(0, carry.size() - (m - 1));
+            }
+            base += c.size();
+        });
+    }
+    template <class OnMatch>
+    void find_all(const TextBuffer &buf, size_t from, OnMatch &&on_match) const {
+        find_all(buf, from, on_match, [](size_t) { return true; });
+    }
+
+private:
+    std::string needle_;
+    bool match_case_;
+    size_t skip_[256] = {};
+
+    static char fold(char c) { return (c >= 'A' && c <= 'Z') ? (char)(c + 32) : c; }
+};
+
+} // namespace SoftGUI
+
+#endif // SOFTGUI_TEXT_HPP
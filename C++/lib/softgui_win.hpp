@@ -12,8 +12,16 @@
 #include <cstring>
 #include <algorithm>
 #include <chrono>
+#include <mutex>
+#include <deque>
 #include <cmath>
 #include <sstream>
+#include <map>
+#include <string_view>
+#include <cstdio>
+#include <typeinfo>
+#include "softgui_raster.hpp"
+#include "softgui_text.hpp"
 
 namespace SoftGUI {
 
@@ -23,13 +31,282 @@ struct Color {
     Color(): r(0),g(0),b(0) {}
     Color(int rr,int gg,int bb): r((uint8_t)rr), g((uint8_t)gg), b((uint8_t)bb) {}
     COLORREF toCOLORREF() const { return RGB(r,g,b); }
+    static Color from(COLORREF c) { return Color(GetRValue(c), GetGValue(c), GetBValue(c)); }
 };
 
 struct Geometry { int x=0,y=0,w=100,h=24; };
 
+// ---------- GDI accounting ----------
+// SoftGUI creates its GDI objects through these helpers so Window can report
+// how many were allocated per frame (see Window::frame_stats()).
+namespace gdi {
+    inline unsigned long& created() { static unsigned long n = 0; return n; }
+    inline HBRUSH solid_brush(COLORREF c) { ++created(); return CreateSolidBrush(c); }
+    inline HPEN pen(COLORREF c, int width) { ++created(); return CreatePen(PS_SOLID, width, c); }
+    inline HFONT font(int height, const char* face) {
+        ++created();
+        return CreateFontA(height, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
+                           ANSI_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
+                           DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, face);
+    }
+} // namespace gdi
+
+#ifndef WM_DPICHANGED
+#define WM_DPICHANGED 0x02E0
+#endif
+
+// ---------- Font cache ----------
+// Process-wide HFONT cache shared by all widgets, keyed by (face, point size, LOGPIXELSY).
+// Fonts handed out by get() are owned by the cache: select them, never delete them.
+// metrics() adds a per-font table of single-byte advance widths, measured once.
+class FontCache {
+public:
+    struct Metrics {
+        int advance[256];  // GetCharWidth32 advances; sums match GetTextExtentPoint32
+        int height;        // tmHeight
+    };
+
+    ~FontCache() {
+        clear();
+        if (measure_dc_) DeleteDC(measure_dc_);
+    }
+
+    HFONT get(const std::string &face, int size, int dpi) {
+        Key k{face, size, dpi};
+        auto it = fonts_.find(k);
+        if (it != fonts_.end()) return it->second;
+        HFONT f = gdi::font(-MulDiv(size, dpi, 72), face.c_str());
+        fonts_.emplace(std::move(k), f);
+        return f;
+    }
+
+    // advance widths of a font from get() (or any font that outlives its use here)
+    const Metrics& metrics(HFONT f) {
+        auto it = metrics_.find(f);
+        if (it != metrics_.end()) return *it->second;
+        std::unique_ptr<Metrics> m(new Metrics());
+        HDC dc = measure_dc();
+        HGDIOBJ old = SelectObject(dc, f);
+        if (!GetCharWidth32A(dc, 0, 255, m->advance)) {
+            for (int c = 0; c < 256; ++c) {
+                char ch = (char)c;
+                SIZE sz{0,0};
+                GetTextExtentPoint32A(dc, &ch, 1, &sz);
+                m->advance[c] = sz.cx;
+            }
+        }
+        TEXTMETRICA tm;
+        GetTextMetricsA(dc, &tm);
+        m->height = tm.tmHeight;
+        SelectObject(dc, old);
+        return *metrics_.emplace(f, std::move(m)).first->second;
+    }
+
+    // drop every cached font (DPI change, theme change); widgets pick up new ones on their next draw
+    void clear() {
+        for (auto &kv : fonts_) DeleteObject(kv.second);
+        fonts_.clear();
+        metrics_.clear();
+    }
+
+    // screen-compatible memory DC for text measurement outside of WM_PAINT
+    HDC measure_dc() {
+        if (!measure_dc_) { measure_dc_ = CreateCompatibleDC(NULL); ++gdi::created(); }
+        return measure_dc_;
+    }
+
+    size_t size() const { return fonts_.size(); }
+
+private:
+    struct Key {
+        std::string face;
+        int size, dpi;
+        bool operator<(const Key &o) const {
+            if (size != o.size) return size < o.size;
+            if (dpi != o.dpi) return dpi < o.dpi;
+            return face < o.face;
+        }
+    };
+    std::map<Key, HFONT> fonts_;
+    std::map<HFONT, std::unique_ptr<Metrics>> metrics_;
+    HDC measure_dc_ = NULL;
+};
+
+inline FontCache& font_cache() { static FontCache c; return c; }
+
+// ---------- Theme / palette ----------
+// Colours the built-in widgets paint with. Restyle by editing theme() before the
+// first paint (or call palette().clear() and invalidate the window afterwards).
+struct Theme {
+    Color window        = Color::from(GetSysColor(COLOR_WINDOW));
+    Color button_face   = Color::from(GetSysColor(COLOR_BTNFACE));
+    Color field         = Color(255,255,255);   // Entry / ListBox / ComboBox background
+    Color border        = Color(0,0,0);
+    Color track         = Color(200,200,200);   // slider track
+    Color selection     = Color(180,200,240);   // selected list rows
+    Color popup         = Color(240,240,240);   // open ComboBox list
+    Color progress_bg   = Color(230,230,230);
+    Color progress_fill = Color(100,180,120);
+    Color marquee       = Color(100,160,240);
+    Color scrollbar     = Color(160,160,160);   // list scroll thumb
+};
+
+inline Theme& theme() { static Theme t; return t; }
+
+// Process-wide cache of solid brushes and pens, created on first use and shared by
+// every widget. Apps can register their own named colours with define().
+class Palette {
+public:
+    ~Palette() { clear(); }
+
+    HBRUSH brush(const Color &c) {
+        COLORREF k = c.toCOLORREF();
+        auto it = brushes_.find(k);
+        if (it != brushes_.end()) return it->second;
+        HBRUSH b = gdi::solid_brush(k);
+        brushes_.emplace(k, b);
+        return b;
+    }
+
+    HPEN pen(const Color &c, int width = 1) {
+        uint64_t k = ((uint64_t)(uint32_t)width << 32) | c.toCOLORREF();
+        auto it = pens_.find(k);
+        if (it != pens_.end()) return it->second;
+        HPEN p = gdi::pen(c.toCOLORREF(), width);
+        pens_.emplace(k, p);
+        return p;
+    }
+
+    // named application colours
+    void define(const std::string &name, const Color &c) { named_[name] = c; }
+    Color color(const std::string &name) const {
+        auto it = named_.find(name);
+        return it != named_.end() ? it->second : Color();
+    }
+    HBRUSH brush(const std::string &name) { return brush(color(name)); }
+    HPEN pen(const std::string &name, int width = 1) { return pen(color(name), width); }
+
+    // release every cached object (names are kept)
+    void clear() {
+        for (auto &kv : brushes_) DeleteObject(kv.second);
+        for (auto &kv : pens_) DeleteObject(kv.second);
+        brushes_.clear();
+        pens_.clear();
+    }
+
+private:
+    std::map<COLORREF, HBRUSH> brushes_;
+    std::map<uint64_t, HPEN> pens_;
+    std::map<std::string, Color> named_;
+};
+
+inline Palette& palette() { static Palette p; return p; }
+
+// per-frame paint statistics, refreshed on every WM_PAINT
+struct FrameStats {
+    unsigned long frames = 0;        // WM_PAINTs handled so far
+    unsigned widgets_drawn = 0;      // widgets redrawn in the last frame
+    unsigned long gdi_allocs = 0;    // GDI objects created during the last frame (0 in steady state)
+    DWORD gdi_handles = 0;           // process-wide GDI handle count after the last frame
+    double frame_ms = 0;             // WM_PAINT duration of the last frame (SOFTGUI_PROFILE builds only)
+    double input_latency_ms = 0;     // oldest unanswered input to the end of the next frame (SOFTGUI_PROFILE builds only)
+};
+
+// ---------- Profiler ----------
+// Define SOFTGUI_PROFILE before including this header to time WM_PAINT, layout, animation ticks
+// and every widget draw(). Events go to a process-wide buffer that write_chrome_trace() dumps
+// for chrome://tracing or Perfetto. Without the macro SOFTGUI_PROF_SCOPE expands to nothing.
+#ifdef SOFTGUI_PROFILE
+namespace prof {
+    struct Event {
+        const char* name;   // static string: a literal or typeid(...).name()
+        int64_t start_us;
+        int64_t dur_us;
+        DWORD tid;
+    };
+
+    struct Recorder {
+        std::mutex mu;
+        std::vector<Event> events;
+        size_t capacity = (size_t)1 << 20; // later events are counted in dropped, not stored
+        size_t dropped = 0;
+    };
+    inline Recorder& recorder() { static Recorder r; return r; }
+
+    // QueryPerformanceCounter in microseconds, split so the multiply cannot overflow
+    inline int64_t now_us() {
+        static const int64_t freq = [] { LARGE_INTEGER f; QueryPerformanceFrequency(&f); return (int64_t)f.QuadPart; }();
+        LARGE_INTEGER c;
+        QueryPerformanceCounter(&c);
+        return (c.QuadPart / freq) * 1000000 + (c.QuadPart % freq) * 1000000 / freq;
+    }
+
+    inline void record(const char* name, int64_t start_us, int64_t dur_us) {
+        Recorder &r = recorder();
+        std::lock_guard<std::mutex> lk(r.mu);
+        if (r.events.size() >= r.capacity) { ++r.dropped; return; }
+        r.events.push_back(Event{name, start_us, dur_us, GetCurrentThreadId()});
+    }
+
+    inline void clear() {
+        Recorder &r = recorder();
+        std::lock_guard<std::mutex> lk(r.mu);
+        r.events.clear();
+        r.dropped = 0;
+    }
+
+    // times its own lifetime; use through SOFTGUI_PROF_SCOPE
+    class Scope {
+    public:
+        explicit Scope(const char* name) : name_(name), t0_(now_us()) {}
+        ~Scope() { record(name_, t0_, now_us() - t0_); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        const char* name_;
+        int64_t t0_;
+    };
+
+    // write the recorded events as Chrome trace JSON ("X" complete events); false if the file can't be opened
+    inline bool write_chrome_trace(const char* path) {
+        FILE *f = fopen(path, "wb");
+        if (!f) return false;
+        Recorder &r = recorder();
+        std::lock_guard<std::mutex> lk(r.mu);
+        int64_t base = r.events.empty() ? 0 : r.events.front().start_us;
+        for (const Event &ev : r.events) base = std::min(base, ev.start_us);
+        DWORD pid = GetCurrentProcessId();
+        fputs("{\"traceEvents\":[\n", f);
+        for (size_t i = 0; i < r.events.size(); ++i) {
+            const Event &ev = r.events[i];
+            fputs("{\"name\":\"", f);
+            for (const char *p = ev.name; *p; ++p) {
+                if (*p == '"' || *p == '\\') fputc('\\', f);
+                fputc(*p, f);
+            }
+            fprintf(f, "\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%lu,\"tid\":%lu}%s\n",
+                    (long long)(ev.start_us - base), (long long)ev.dur_us, (unsigned long)pid,
+                    (unsigned long)ev.tid, i + 1 < r.events.size() ? "," : "");
+        }
+        fprintf(f, "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%llu}}\n", (unsigned long long)r.dropped);
+        return fclose(f) == 0;
+    }
+} // namespace prof
+
+#define SOFTGUI_PROF_CAT2(a, b) a##b
+#define SOFTGUI_PROF_CAT(a, b) SOFTGUI_PROF_CAT2(a, b)
+#define SOFTGUI_PROF_SCOPE(name) ::SoftGUI::prof::Scope SOFTGUI_PROF_CAT(softgui_prof_scope_, __LINE__)(name)
+#else
+#define SOFTGUI_PROF_SCOPE(name) ((void)0)
+#endif
+
 // ---------- Forward ----------
 struct Widget;
 class Window;
+
+// message that drains Window::post on the UI thread (WM_APP + 0x120 is taken by img_rnd.hpp)
+const UINT WM_SOFTGUI_POST = WM_APP + 0x100;
+
 using WidgetPtr = std::shared_ptr<Widget>;
 
 // ---------- Pack options ----------
@@ -57,21 +334,87 @@ struct Widget {
     std::function<void(Widget*)> on_change;
     bool packed = false;
     PackOptions pack_opts;
+    Window* host = nullptr;              // owning window (set on top-level widgets by Window::register_widget)
+    RECT painted{0,0,0,0};               // area covered by the last draw(), damaged again on the next change
+    bool anim_scheduled = false;         // currently in the host window's animation set
+    int hit_rank = -1;                   // paint order in the window's hit-test grid (-1 = not indexed)
+    RECT hit_rect{0,0,0,0};              // rect the grid currently files this widget under
 
     virtual ~Widget() {}
     virtual void measure() {}
     virtual void draw(HDC hdc) {}
     virtual void on_click_internal(int x,int y) { if (on_click) on_click(this); }
     virtual void on_key_internal(char ch) { if (on_key) on_key(this, ch); }
-    virtual void mark_dirty() { dirty = true; if (parent) parent->mark_dirty(); }
+    // flags the widget and adds its old + new bounds to the host window's damage region (defined after Window)
+    virtual void mark_dirty();
+
+    // true while the widget needs animation ticks; mark_dirty() schedules it with the host window,
+    // so change target values and then call mark_dirty() as usual
+    virtual bool is_animating() const { return false; }
+    // one animation step while scheduled: dt in seconds, alpha = frame-rate independent easing factor
+    virtual void animate(float dt, float alpha) {}
+    // mouse moved / released while this widget holds the capture (widget-local coordinates)
+    virtual void on_drag(int x, int y) {}
+    virtual void on_release(int x, int y) {}
+    // mouse wheel over the widget (WHEEL_DELTA units, positive = away from the user)
+    virtual void on_wheel(int delta) {}
+
+    // shared easing step for smoothed widgets; fires on_change when the rounded value changes
+    void ease_value(float &fvalue, float target, int &value, float alpha) {
+        if (std::fabs(target - fvalue) <= 0.001f) return;
+        fvalue += (target - fvalue) * alpha;
+        // snap if very close
+        if (std::fabs(target - fvalue) < 0.001f) fvalue = target;
+        int newv = (int)std::lround(fvalue);
+        if (newv != value) {
+            value = newv;
+            if (on_change) on_change(this);
+        }
+        mark_dirty();
+    }
+
+    // end of a drag on a smoothed widget: jump straight to the target
+    void settle_value(float &fvalue, float target, int &value) {
+        fvalue = target;
+        int newv = (int)std::lround(fvalue);
+        if (newv != value) {
+            value = newv;
+            if (on_change) on_change(this);
+        }
+    }
+
+    // window of the top-level ancestor (nullptr until registered)
+    Window* host_window() const {
+        const Widget* top = this;
+        while (top->parent) top = top->parent;
+        return top->host;
+    }
+    // visible itself and through every ancestor frame
+    bool shown() const {
+        for (const Widget* w = this; w; w = w->parent) if (!w->visible) return false;
+        return true;
+    }
+
+    // area this widget paints; widgets that draw outside geom (e.g. an open ComboBox) override it
+    virtual RECT bounds() const { return RECT{geom.x, geom.y, geom.x + geom.w, geom.y + geom.h}; }
+
+    // shared font for this widget's face/size at hdc's DPI (owned by font_cache(), do not delete)
+    HFONT font(HDC hdc) const {
+        return font_cache().get(font_name, font_size, GetDeviceCaps(hdc, LOGPIXELSY));
+    }
+
+    // outline r with the theme border pen, leaving the interior untouched
+    static void draw_border(HDC hdc, const RECT &r) {
+        HGDIOBJ oldPen = SelectObject(hdc, palette().pen(theme().border));
+        HGDIOBJ oldBrush = SelectObject(hdc, GetStockObject(NULL_BRUSH));
+        Rectangle(hdc, r.left, r.top, r.right, r.bottom);
+        SelectObject(hdc, oldBrush);
+        SelectObject(hdc, oldPen);
+    }
 
-    // create a font (caller must delete returned HFONT)
+    // create a private font (caller must delete returned HFONT); prefer font() in draw code
     HFONT make_font(HDC hdc) {
-        return CreateFontA(
-            -MulDiv(font_size, GetDeviceCaps(hdc, LOGPIXELSY), 72),
-            0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-            ANSI_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-            DEFAULT_QUALITY, DEFAULT_PITCH | FF_DONTCARE, font_name.c_str());
+        return gdi::font(-MulDiv(font_size, GetDeviceCaps(hdc, LOGPIXELSY), 72), font_name.c_str());
     }
 };
 
@@ -79,10 +422,26 @@ struct Widget {
 struct Frame : Widget {
     std::vector<WidgetPtr> children;
     Frame() {}
-    void add_child(WidgetPtr w) { w->parent = this; children.push_back(w); }
+    void add_child(WidgetPtr w); // defined after Window (re-indexes the host's hit-test grid)
+    // children use absolute coordinates, so the frame covers its own rect plus theirs
+    RECT bounds() const override {
+        RECT r = Widget::bounds();
+        for (auto &c : children) {
+            RECT cb = c->bounds();
+            UnionRect(&r, &r, &cb);
+        }
+        return r;
+    }
     void draw(HDC hdc) override {
         for (auto &c : children) {
-            if (c->visible) c->draw(hdc);
+            RECT cb = c->bounds();
+            // skip children entirely outside the current damage clip
+            if (c->visible && RectVisible(hdc, &cb)) {
+                SOFTGUI_PROF_SCOPE(typeid(*c).name());
+                c->draw(hdc);
+                c->painted = cb;
+                c->dirty = false;
+            }
         }
     }
 };
@@ -92,105 +451,198 @@ struct Label : Widget {
     Label(const std::string& txt="") { text = txt; }
     void draw(HDC hdc) override {
         RECT r{geom.x, geom.y, geom.x + geom.w, geom.y + geom.h};
-        HBRUSH bg = CreateSolidBrush(GetSysColor(COLOR_WINDOW));
-        FillRect(hdc, &r, bg); DeleteObject(bg);
+        FillRect(hdc, &r, palette().brush(theme().window));
 
-        HFONT hFont = make_font(hdc);
+        HFONT hFont = font(hdc);
         HFONT hOld = (HFONT)SelectObject(hdc, hFont);
         SetBkMode(hdc, TRANSPARENT);
         DrawTextA(hdc, text.c_str(), (int)text.size(), &r, DT_SINGLELINE | DT_LEFT | DT_VCENTER);
         SelectObject(hdc, hOld);
-        DeleteObject(hFont);
     }
 };
 
 // ---------- Entry (single-line) ----------
+// Text positions come from the font cache's advance table: prefix widths are rebuilt only
+// when the text or font changes, and the view scrolls horizontally to keep the caret shown.
+// Keys edit a TextBuffer in O(log n) and each run of typing keeps an O(1) snapshot for undo
+// (Ctrl+Z). `text` is a view of the buffer rebuilt lazily: on draw(), before on_change fires,
+// on a click anywhere in the window and by value(), which timers and the like should use.
+// Callers may still assign `text` and call mark_dirty() as for any widget: the buffer reloads
+// from it on the next edit, dropping the undo history.
 struct Entry : Widget {
     bool focused = false;
     size_t caret = 0;
-    std::chrono::steady_clock::time_point last_blink;
     bool caret_visible = true;
-    Entry(const std::string &txt="") { text = txt; last_blink = std::chrono::steady_clock::now(); }
+    int scroll_x = 0; // pixels of text scrolled off the left edge
+    Entry(const std::string &txt="") : buf_(txt) { text = txt; }
+
+    const std::string& value() { sync(); materialize(); return text; }
+    const TextBuffer& buffer() { sync(); return buf_; }
+    size_t length() { sync(); return buf_.size(); }
+    bool can_undo() const { return !undo_.empty(); }
+    void undo() {
+        sync();
+        if (undo_.empty()) return;
+        buf_ = std::move(undo_.back().text);
+        caret = undo_.back().caret;
+        undo_.pop_back();
+        last_edit_ = Edit::None;
+        edited();
+        repaint();
+    }
+
+    // caller-side change: `text` may have been assigned, check it against the buffer on the next edit
+    void mark_dirty() override { maybe_assigned_ = true; Widget::mark_dirty(); }
+    // redraw for caret / focus / own edits, without implying that `text` changed
+    void repaint() { Widget::mark_dirty(); }
 
     void draw(HDC hdc) override {
+        sync();
+        materialize();
         RECT r{geom.x, geom.y, geom.x + geom.w, geom.y + geom.h};
-        HBRUSH hbr = CreateSolidBrush(RGB(255,255,255));
-        FillRect(hdc, &r, hbr); DeleteObject(hbr);
+        FillRect(hdc, &r, palette().brush(theme().field));
 
         // border
-        Rectangle(hdc, r.left, r.top, r.right, r.bottom);
+        draw_border(hdc, r);
 
-        HFONT hFont = make_font(hdc);
+        HFONT hFont = font(hdc);
         HFONT hOld = (HFONT)SelectObject(hdc, hFont);
         SetBkMode(hdc, TRANSPARENT);
 
-        RECT tr = r;
-        tr.left += 4;
-        DrawTextA(hdc, text.c_str(), (int)text.size(), &tr, DT_SINGLELINE | DT_LEFT | DT_VCENTER);
+        const std::vector<int> &px = prefix(hFont);
+        scroll_to_caret();
+        RECT tr = interior();
+        int ty = r.top + (geom.h - font_cache().metrics(hFont).height) / 2;
+        ExtTextOutA(hdc, tr.left - scroll_x, ty, ETO_CLIPPED, &tr, text.c_str(), (UINT)text.size(), nullptr);
 
-        // caret (visibility controlled by tick_animate)
+        // caret (visibility toggled by the window's caret blink timer)
         if (focused && caret_visible) {
-            int cx = tr.left + TextWidth(hdc, text.c_str(), (int)caret);
-            MoveToEx(hdc, cx, tr.top+4, nullptr);
-            LineTo(hdc, cx, tr.bottom-4);
+            int cx = tr.left - scroll_x + px[std::min(caret, text.size())];
+            MoveToEx(hdc, cx, r.top+4, nullptr);
+            LineTo(hdc, cx, r.bottom-4);
         }
 
         SelectObject(hdc, hOld);
-        DeleteObject(hFont);
     }
 
     virtual void on_click_internal(int x,int y) override {
+        sync();
+        materialize();
         focused = true;
         caret = std::min<size_t>(text.size(), (size_t)TextIndexFromPos(x));
         if (on_focus) on_focus(this);
-        mark_dirty();
+        repaint();
     }
 
     void on_key_internal(char ch) override {
+        sync();
         if (ch == '\b') {
-            if (!text.empty() && caret>0) {
-                text.erase(caret-1,1);
-                caret = (caret==0?0:caret-1);
-                if (on_change) on_change(this);
+            if (caret > 0) {
+                save_undo(Edit::Erase);
+                buf_.erase(--caret, 1);
+                last_caret_ = caret;
+                edited();
             }
         } else if (ch == '\r') {
             focused = false;
-            if (on_change) on_change(this);
+            if (on_change) { materialize(); on_change(this); }
+        } else if (ch == 0x1A) { // Ctrl+Z
+            undo();
         } else if (ch >= 32) {
-            text.insert(caret, 1, ch);
-            caret++;
-            if (on_change) on_change(this);
+            save_undo(Edit::Insert);
+            buf_.insert(caret++, std::string_view(&ch, 1));
+            last_caret_ = caret;
+            edited();
         }
-        mark_dirty();
+        repaint();
     }
 
 private:
-    static int TextWidth(HDC hdc, const char* s, int upto = -1) {
-        if (!s) return 0;
-        int len = (upto < 0) ? (int)strlen(s) : upto;
-        SIZE sz{0,0};
-        GetTextExtentPoint32A(hdc, s, len, &sz);
-        return sz.cx;
+    enum class Edit { None, Insert, Erase };
+    struct UndoStep { TextBuffer text; size_t caret; };
+    static constexpr size_t kMaxUndo = 256;
+
+    TextBuffer buf_;
+    bool text_stale_ = false;       // buf_ has edits not yet copied into `text`
+    bool maybe_assigned_ = false;   // mark_dirty() came from outside since the last sync()
+    std::deque<UndoStep> undo_;
+    Edit last_edit_ = Edit::None;   // kind of the previous edit, for grouping typed runs
+    size_t last_caret_ = 0;         // caret right after that edit
+
+    // pick up a direct assignment to `text`; only compared after an outside mark_dirty(),
+    // never on the typing path
+    void sync() {
+        if (!maybe_assigned_) return;
+        maybe_assigned_ = false;
+        if (text_stale_) return; // `text` is behind the buffer, so nobody can have assigned a newer one
+        bool same = text.size() == buf_.size();
+        size_t off = 0;
+        if (same) buf_.for_each_chunk([&](std::string_view c) {
+            if (same) same = text.compare(off, c.size(), c.data(), c.size()) == 0;
+            off += c.size();
+        });
+        if (same) return;
+        buf_ = TextBuffer(text);
+        undo_.clear();
+        last_edit_ = Edit::None;
+        caret = std::min(caret, text.size());
+    }
+    void materialize() {
+        if (!text_stale_) return;
+        text = buf_.str();
+        text_stale_ = false;
+    }
+    // one undo step per run of typing or of backspacing at the caret
+    void save_undo(Edit kind) {
+        if (kind == last_edit_ && caret == last_caret_) return;
+        if (undo_.size() == kMaxUndo) undo_.pop_front();
+        undo_.push_back(UndoStep{buf_.snapshot(), caret});
+        last_edit_ = kind;
+    }
+    void edited() {
+        text_stale_ = true;
+        caret = std::min(caret, buf_.size());
+        if (on_change) { materialize(); on_change(this); }
+    }
+
+    std::vector<int> prefix_;   // prefix_[i] = width of text[0, i)
+    std::string prefix_text_;   // text the prefix widths were built for
+    HFONT prefix_font_ = NULL;
+
+    // text area inside the border and padding
+    RECT interior() const { return RECT{geom.x + 4, geom.y + 1, geom.x + geom.w - 4, geom.y + geom.h - 1}; }
+
+    const std::vector<int>& prefix(HFONT f) {
+        materialize();
+        if (f == prefix_font_ && prefix_.size() == text.size() + 1 && prefix_text_ == text) return prefix_;
+        const FontCache::Metrics &m = font_cache().metrics(f);
+        prefix_.resize(text.size() + 1);
+        prefix_[0] = 0;
+        for (size_t i = 0; i < text.size(); ++i) prefix_[i + 1] = prefix_[i] + m.advance[(unsigned char)text[i]];
+        prefix_text_ = text;
+        prefix_font_ = f;
+        return prefix_;
+    }
+
+    // keep the caret inside the interior, and no empty space right of the text
+    void scroll_to_caret() {
+        int avail = std::max(1, geom.w - 8);
+        int cx = prefix_[std::min(caret, text.size())];
+        if (cx - scroll_x > avail - 1) scroll_x = cx - avail + 1;
+        if (cx < scroll_x) scroll_x = cx;
+        scroll_x = std::clamp(scroll_x, 0, std::max(0, prefix_.back() - avail + 1));
     }
 
-    // position is local x inside widget (not screen)
+    // position is local x inside widget (not screen); lands on the nearest character boundary
     int TextIndexFromPos(int local_px) {
-        HDC hdc = GetDC(NULL);
-        HFONT h = make_font(hdc);
-        HFONT hold = (HFONT)SelectObject(hdc, h);
-        int offset = local_px - 4; // left padding
-        if (offset <= 0) { SelectObject(hdc, hold); DeleteObject(h); ReleaseDC(NULL, hdc); return 0; }
-        int idx = 0;
-        for (size_t i=1;i<=text.size();++i) {
-            SIZE sz{0,0};
-            GetTextExtentPoint32A(hdc, text.c_str(), (int)i, &sz);
-            if (sz.cx >= offset) { idx = (int)i; break; }
-            idx = (int)i;
-        }
-        SelectObject(hdc, hold);
-        DeleteObject(h);
-        ReleaseDC(NULL, hdc);
-        return idx;
+        HDC hdc = font_cache().measure_dc();
+        const std::vector<int> &px = prefix(font(hdc));
+        int offset = local_px - 4 + scroll_x; // left padding
+        if (offset <= 0) return 0;
+        size_t i = std::lower_bound(px.begin(), px.end(), offset) - px.begin();
+        if (i >= px.size()) return (int)text.size();
+        if (i > 0 && offset - px[i - 1] < px[i] - offset) --i;
+        return (int)i;
     }
 };
 
@@ -200,16 +652,14 @@ struct Button : Widget {
     Button(const std::string &txt="") { text = txt; }
     void draw(HDC hdc) override {
         RECT r{geom.x, geom.y, geom.x + geom.w, geom.y + geom.h};
-        HBRUSH bg = CreateSolidBrush(GetSysColor(COLOR_BTNFACE));
-        FillRect(hdc, &r, bg); DeleteObject(bg);
+        FillRect(hdc, &r, palette().brush(theme().button_face));
 
         DrawFrameControl(hdc, &r, DFC_BUTTON, DFCS_BUTTONPUSH);
-        HFONT hFont = make_font(hdc);
+        HFONT hFont = font(hdc);
         HFONT hOld = (HFONT)SelectObject(hdc, hFont);
         SetBkMode(hdc, TRANSPARENT);
         DrawTextA(hdc, text.c_str(), (int)text.size(), &r, DT_SINGLELINE | DT_CENTER | DT_VCENTER);
         SelectObject(hdc, hOld);
-        DeleteObject(hFont);
     }
     void on_click_internal(int x,int y) override {
         if (onclick0) onclick0();
@@ -218,27 +668,163 @@ struct Button : Widget {
 };
 
 // ---------- Canvas ----------
+// BGR24 keeps the original std::vector buffer (converted by StretchDIBits on every draw).
+// BGRA32 renders into a 32-bit top-down DIB section: `pixels` is directly writable
+// and draw() is a plain BitBlt when the canvas is shown at its native size. Its fills,
+// lines and alpha blends run through the SIMD kernels in softgui_raster.hpp.
+enum class CanvasFormat { BGR24, BGRA32 };
+
 struct Canvas : Widget {
-    std::vector<uint8_t> buffer; // BGR per pixel
+    std::vector<uint8_t> buffer; // BGR per pixel (BGR24 only)
     int buf_w=0, buf_h=0;
-    Canvas(int w=100,int h=100){ buf_w=w; buf_h=h; geom.w=w; geom.h=h; buffer.resize(std::max(0,w*h*3)); }
+    CanvasFormat format = CanvasFormat::BGR24;
+    uint32_t* pixels = nullptr;  // BGRA32: buf_w * buf_h pixels, rows top-down, owned by the DIB section
+
+    Canvas(int w=100,int h=100, CanvasFormat fmt = CanvasFormat::BGR24) : format(fmt) {
+        buf_w=w; buf_h=h; geom.w=w; geom.h=h;
+        if (format == CanvasFormat::BGRA32) create_dib();
+        else buffer.resize(std::max(0,w*h*3));
+    }
+    ~Canvas() { release_dib(); }
+    Canvas(const Canvas&) = delete;
+    Canvas& operator=(const Canvas&) = delete;
+
+    static uint32_t pack(const Color &c) { return 0xFF000000u | ((uint32_t)c.r << 16) | ((uint32_t)c.g << 8) | c.b; }
+    // view of the BGRA32 pixels for the raster kernels (empty for BGR24)
+    raster::Surface surface() const { return pixels ? raster::Surface{pixels, buf_w, buf_h, buf_w} : raster::Surface{}; }
+
+    // batch edits: dirty marking is deferred until the outermost unlock()
+    void lock() {
+        if (lock_depth_++ == 0 && dib_) GdiFlush(); // finish any pending GDI work on the DIB first
+    }
+    void unlock() {
+        if (lock_depth_ > 0 && --lock_depth_ == 0 && pending_) { pending_ = false; mark_dirty(); }
+    }
+    // RAII wrapper for lock()/unlock()
+    struct Batch {
+        Canvas &c;
+        explicit Batch(Canvas &cv) : c(cv) { c.lock(); }
+        ~Batch() { c.unlock(); }
+    };
+
     void put_pixel(int x,int y,const Color &c){
         if (x<0||y<0||x>=buf_w||y>=buf_h) return;
-        int idx = (y*buf_w + x)*3;
-        buffer[idx+0] = c.b;
-        buffer[idx+1] = c.g;
-        buffer[idx+2] = c.r;
-        mark_dirty();
+        if (pixels) {
+            pixels[(size_t)y*buf_w + x] = pack(c);
+        } else {
+            int idx = (y*buf_w + x)*3;
+            buffer[idx+0] = c.b;
+            buffer[idx+1] = c.g;
+            buffer[idx+2] = c.r;
+        }
+        touched();
     }
     void clear(const Color &c=Color(255,255,255)) {
-        for (int y=0;y<buf_h;y++) for (int x=0;x<buf_w;x++){
-            int idx=(y*buf_w+x)*3;
-            buffer[idx+0]=c.b; buffer[idx+1]=c.g; buffer[idx+2]=c.r;
+        fill_rect(0, 0, buf_w, buf_h, c);
+    }
+    // solid rectangle, clipped to the canvas
+    void fill_rect(int x, int y, int w, int h, const Color &c) {
+        int x0 = std::max(0, x), y0 = std::max(0, y);
+        int x1 = std::min(buf_w, x + w), y1 = std::min(buf_h, y + h);
+        if (x0 >= x1 || y0 >= y1) return;
+        if (pixels) {
+            raster::fill_rect(surface(), x0, y0, x1 - x0, y1 - y0, pack(c));
+        } else {
+            // fill the first row, then copy it down
+            uint8_t *row0 = &buffer[((size_t)y0*buf_w + x0)*3];
+            for (int xx = 0; xx < x1 - x0; ++xx) { row0[xx*3+0]=c.b; row0[xx*3+1]=c.g; row0[xx*3+2]=c.r; }
+            for (int yy = y0 + 1; yy < y1; ++yy) memcpy(&buffer[((size_t)yy*buf_w + x0)*3], row0, (size_t)(x1 - x0)*3);
         }
-        mark_dirty();
+        touched();
     }
+    // horizontal span [x0, x1) on row y
+    void hspan(int x0, int x1, int y, const Color &c) {
+        if (x1 > x0) fill_rect(x0, y, x1 - x0, 1, c);
+    }
+    // copy a BGRA32 user buffer (src_stride in pixels, 0 = src_w) to (dx, dy), clipped
+    void blit(const uint32_t *src, int src_w, int src_h, int dx, int dy, int src_stride = 0) {
+        if (!src) return;
+        if (src_stride <= 0) src_stride = src_w;
+        int sx0 = std::max(0, -dx), sy0 = std::max(0, -dy);
+        int w = std::min(src_w, buf_w - dx) - sx0;
+        int h = std::min(src_h, buf_h - dy) - sy0;
+        if (w <= 0 || h <= 0) return;
+        for (int yy = 0; yy < h; ++yy) {
+            const uint32_t *s = src + (size_t)(sy0 + yy)*src_stride + sx0;
+            int ty = dy + sy0 + yy, tx = dx + sx0;
+            if (pixels) {
+                memcpy(pixels + (size_t)ty*buf_w + tx, s, (size_t)w*4);
+            } else {
+                uint8_t *d = &buffer[((size_t)ty*buf_w + tx)*3];
+                for (int xx = 0; xx < w; ++xx) { d[xx*3+0]=(uint8_t)s[xx]; d[xx*3+1]=(uint8_t)(s[xx]>>8); d[xx*3+2]=(uint8_t)(s[xx]>>16); }
+            }
+        }
+        touched();
+    }
+    // alpha-blend a straight-alpha BGRA32 sprite at (dx, dy), clipped
+    void blend(const uint32_t *src, int src_w, int src_h, int dx, int dy, int src_stride = 0) {
+        if (!src) return;
+        if (src_stride <= 0) src_stride = src_w;
+        raster::Surface s{const_cast<uint32_t*>(src), src_w, src_h, src_stride};
+        if (pixels) {
+            raster::blend(surface(), s, dx, dy);
+        } else {
+            int sx0 = std::max(0, -dx), sy0 = std::max(0, -dy);
+            int w = std::min(src_w, buf_w - dx) - sx0;
+            int h = std::min(src_h, buf_h - dy) - sy0;
+            if (w <= 0 || h <= 0) return;
+            for (int yy = 0; yy < h; ++yy) {
+                const uint32_t *sp = s.row(sy0 + yy) + sx0;
+                uint8_t *d = &buffer[((size_t)(dy + sy0 + yy)*buf_w + dx + sx0)*3];
+                for (int xx = 0; xx < w; ++xx) {
+                    uint32_t a = sp[xx] >> 24;
+                    for (int ch = 0; ch < 3; ++ch)
+                        d[xx*3+ch] = (uint8_t)raster::lerp255((sp[xx] >> (8*ch)) & 0xFF, d[xx*3+ch], a);
+                }
+            }
+        }
+        touched();
+    }
+    // 1-pixel line from (x0, y0) to (x1, y1), both ends included
+    void line(int x0, int y0, int x1, int y1, const Color &c) {
+        if (pixels) {
+            raster::line(surface(), x0, y0, x1, y1, pack(c));
+            touched();
+            return;
+        }
+        Batch b(*this);
+        int dx = std::abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+        int dy = -std::abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+        for (int err = dx + dy;;) {
+            put_pixel(x0, y0, c);
+            if (x0 == x1 && y0 == y1) break;
+            int e2 = 2 * err;
+            if (e2 >= dy) { err += dy; x0 += sx; }
+            if (e2 <= dx) { err += dx; y0 += sy; }
+        }
+    }
+    // 1-pixel rectangle outline
+    void rect(int x, int y, int w, int h, const Color &c) {
+        if (w <= 0 || h <= 0) return;
+        Batch b(*this);
+        hspan(x, x + w, y, c);
+        hspan(x, x + w, y + h - 1, c);
+        if (h > 2) { line(x, y + 1, x, y + h - 2, c); line(x + w - 1, y + 1, x + w - 1, y + h - 2, c); }
+    }
+
     void draw(HDC hdc) override {
-        if (buf_w<=0||buf_h<=0 || buffer.empty()) return;
+        if (buf_w<=0||buf_h<=0) return;
+        if (dib_) {
+            if (geom.w == buf_w && geom.h == buf_h) {
+                BitBlt(hdc, geom.x, geom.y, buf_w, buf_h, dib_dc_, 0, 0, SRCCOPY);
+            } else {
+                int oldMode = SetStretchBltMode(hdc, COLORONCOLOR);
+                StretchBlt(hdc, geom.x, geom.y, geom.w, geom.h, dib_dc_, 0, 0, buf_w, buf_h, SRCCOPY);
+                SetStretchBltMode(hdc, oldMode);
+            }
+            return;
+        }
+        if (buffer.empty()) return;
         BITMAPINFO bmi;
         ZeroMemory(&bmi,sizeof(bmi));
         bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
@@ -250,6 +836,40 @@ struct Canvas : Widget {
         StretchDIBits(hdc, geom.x, geom.y, geom.w, geom.h,
                       0,0,buf_w,buf_h, buffer.data(), &bmi, DIB_RGB_COLORS, SRCCOPY);
     }
+
+private:
+    HBITMAP dib_ = NULL;
+    HDC dib_dc_ = NULL;
+    HGDIOBJ dib_old_ = NULL;
+    int lock_depth_ = 0;
+    bool pending_ = false;
+
+    void touched() { if (lock_depth_) pending_ = true; else mark_dirty(); }
+
+    void create_dib() {
+        if (buf_w <= 0 || buf_h <= 0) return;
+        BITMAPINFO bmi;
+        ZeroMemory(&bmi,sizeof(bmi));
+        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bmi.bmiHeader.biWidth = buf_w;
+        bmi.bmiHeader.biHeight = -buf_h; // top-down
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+        void *bits = nullptr;
+        dib_ = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+        if (!dib_) return;
+        dib_dc_ = CreateCompatibleDC(NULL);
+        gdi::created() += 2;
+        dib_old_ = SelectObject(dib_dc_, dib_);
+        pixels = (uint32_t*)bits;
+        raster::clear(surface(), 0xFF000000u); // black, like the zeroed BGR24 buffer
+    }
+    void release_dib() {
+        if (dib_dc_) { SelectObject(dib_dc_, dib_old_); DeleteDC(dib_dc_); dib_dc_ = NULL; }
+        if (dib_) { DeleteObject(dib_); dib_ = NULL; }
+        pixels = nullptr;
+    }
 };
 
 // ---------- Checkbox ----------
@@ -265,13 +885,12 @@ struct Checkbox : Widget {
             LineTo(hdc, r.left+7, r.top+12);
             LineTo(hdc, r.left+13, r.top+4);
         }
-        HFONT hFont = make_font(hdc);
+        HFONT hFont = font(hdc);
         HFONT hOld = (HFONT)SelectObject(hdc, hFont);
         SetBkMode(hdc, TRANSPARENT);
         RECT tr = r; tr.left += 20;
         DrawTextA(hdc, text.c_str(), (int)text.size(), &tr, DT_SINGLELINE | DT_LEFT | DT_VCENTER);
         SelectObject(hdc, hOld);
-        DeleteObject(hFont);
     }
     void on_click_internal(int x,int y) override {
         checked = !checked;
@@ -291,13 +910,12 @@ struct RadioButton : Widget {
         if (selected) {
             Ellipse(hdc, r.left+4, r.top+4, r.left+12, r.top+12);
         }
-        HFONT hFont = make_font(hdc);
+        HFONT hFont = font(hdc);
         HFONT hOld = (HFONT)SelectObject(hdc, hFont);
         SetBkMode(hdc, TRANSPARENT);
         RECT tr = r; tr.left += 20;
         DrawTextA(hdc, text.c_str(), (int)text.size(), &tr, DT_SINGLELINE | DT_LEFT | DT_VCENTER);
         SelectObject(hdc, hOld);
-        DeleteObject(hFont);
     }
     void on_click_internal(int x,int y) override {
         // if inside a Frame, clear group siblings with same group_id
@@ -324,11 +942,11 @@ struct HSlider : Widget {
     float target = 50.0f;        // animated target
     bool dragging = false;
     HSlider(int mn=0,int mx=100,int val=50) : min(mn), max(mx), value(val), fvalue((float)val), target((float)val) {}
+    bool is_animating() const override { return std::fabs(target - fvalue) > 0.001f; }
     void draw(HDC hdc) override {
         // draw track
         RECT r{geom.x, geom.y + geom.h/2 - 4, geom.x + geom.w, geom.y + geom.h/2 + 4};
-        HBRUSH bg = CreateSolidBrush(RGB(200,200,200));
-        FillRect(hdc, &r, bg); DeleteObject(bg);
+        FillRect(hdc, &r, palette().brush(theme().track));
 
         int range = std::max(1, max - min);
         int pos = geom.x + (int)((fvalue - min) * (geom.w - 16) / (float)range);
@@ -337,13 +955,21 @@ struct HSlider : Widget {
     }
     void on_click_internal(int x,int y) override {
         // set immediate target from click and start dragging
+        // don't call on_change here; animate() calls it when the integer value changes
+        on_drag(x, y);
+    }
+    void on_drag(int x, int y) override {
         int newval = min + x * (max - min) / std::max(1, geom.w - 16);
         newval = std::clamp(newval, min, max);
         target = (float)newval;
         dragging = true;
-        // don't call on_change here; Window's timer will call on_change when integer changes
         mark_dirty();
     }
+    void on_release(int x, int y) override {
+        dragging = false;
+        settle_value(fvalue, target, value);
+    }
+    void animate(float dt, float alpha) override { ease_value(fvalue, target, value, alpha); }
 };
 
 // ---------- Vertical Slider (smoothed) ----------
@@ -354,15 +980,16 @@ struct VSlider : Widget {
     float target = 50.0f;
     bool dragging = false;
     VSlider(int mn=0,int mx=100,int val=50) : min(mn), max(mx), value(val), fvalue((float)val), target((float)val) {}
+    bool is_animating() const override { return std::fabs(target - fvalue) > 0.001f; }
     void draw(HDC hdc) override {
         RECT bar{geom.x + geom.w/2 - 4, geom.y, geom.x + geom.w/2 + 4, geom.y + geom.h};
-        HBRUSH bg = CreateSolidBrush(RGB(200,200,200));
-        FillRect(hdc, &bar, bg); DeleteObject(bg);
+        FillRect(hdc, &bar, palette().brush(theme().track));
         int range = std::max(1, max - min);
         int pos = geom.y + (geom.h - 16) - (int)((fvalue - min) * (geom.h - 16) / (float)range);
         RoundRect(hdc, geom.x + 2, pos, geom.x + geom.w - 2, pos + 16, 4, 4);
     }
-    void on_click_internal(int x,int y) override {
+    void on_click_internal(int x,int y) override { on_drag(x, y); }
+    void on_drag(int x, int y) override {
         int rel = y;
         int newval = min + (geom.h - rel - 16) * (max - min) / std::max(1, geom.h - 16);
         newval = std::clamp(newval, min, max);
@@ -370,81 +997,176 @@ struct VSlider : Widget {
         dragging = true;
         mark_dirty();
     }
+    void on_release(int x, int y) override {
+        dragging = false;
+        settle_value(fvalue, target, value);
+    }
+    void animate(float dt, float alpha) override { ease_value(fvalue, target, value, alpha); }
 };
 
-// ---------- ListBox (single-select) ----------
-struct ListBox : Widget {
+// ---------- Row selection set (one bit per row) ----------
+struct RowSet {
+    std::vector<uint64_t> bits;
+    size_t set_count = 0;
+
+    bool test(size_t i) const { return (i >> 6) < bits.size() && (bits[i >> 6] >> (i & 63) & 1); }
+    void set(size_t i, bool on) {
+        if ((i >> 6) >= bits.size()) { if (!on) return; bits.resize((i >> 6) + 1, 0); }
+        uint64_t m = (uint64_t)1 << (i & 63);
+        bool was = (bits[i >> 6] & m) != 0;
+        if (was == on) return;
+        if (on) { bits[i >> 6] |= m; ++set_count; } else { bits[i >> 6] &= ~m; --set_count; }
+    }
+    void clear() { bits.clear(); set_count = 0; }
+    size_t count() const { return set_count; }
+};
+
+// ---------- List base (shared by ListBox / MultiListBox) ----------
+// Rows come from `items`, or in virtual mode from `provider`: set row_count and a
+// callback returning a view of row i (it must stay valid until draw returns).
+// Only the visible window of rows is ever touched.
+struct ListBase : Widget {
     std::vector<std::string> items;
-    int selected = -1;
+    std::function<std::string_view(size_t)> provider;
+    size_t row_count = 0;        // number of rows in virtual mode
+    size_t top_row = 0;          // first visible row (scroll position)
     int item_height = 20;
+    static constexpr int kScrollbarW = 8;
+
+    size_t count() const { return provider ? row_count : items.size(); }
+    std::string_view row(size_t i) const { return provider ? provider(i) : std::string_view(items[i]); }
+    size_t visible_rows() const { return (size_t)std::max(1, geom.h / std::max(1, item_height)); }
+    size_t max_top() const { size_t n = count(), v = visible_rows(); return n > v ? n - v : 0; }
+
+    void scroll_to(size_t top) {
+        top = std::min(top, max_top());
+        if (top != top_row) { top_row = top; mark_dirty(); }
+    }
+    void ensure_visible(size_t i) {
+        if (i < top_row) scroll_to(i);
+        else if (i >= top_row + visible_rows()) scroll_to(i + 1 - visible_rows());
+    }
+
+    virtual bool row_selected(size_t i) const { return false; }
+    virtual void on_row_click(size_t i) {}
+
     void draw(HDC hdc) override {
         RECT r{geom.x, geom.y, geom.x + geom.w, geom.y + geom.h};
-        HBRUSH bg = CreateSolidBrush(RGB(255,255,255));
-        FillRect(hdc, &r, bg); DeleteObject(bg);
-        Rectangle(hdc, r.left, r.top, r.right, r.bottom);
-        HFONT hFont = make_font(hdc);
-        HFONT hOld = (HFONT)SelectObject(hdc, hFont);
+        FillRect(hdc, &r, palette().brush(theme().field));
+        draw_border(hdc, r);
+        HFONT hOld = (HFONT)SelectObject(hdc, font(hdc));
+        SetBkMode(hdc, TRANSPARENT);
+        size_t n = count();
+        if (top_row > max_top()) top_row = max_top();
+        bool scroll = n > visible_rows();
+        int right = scroll ? r.right - kScrollbarW : r.right;
         int yoff = r.top;
-        for (size_t i=0;i<items.size();++i) {
-            RECT tr = { r.left + 2, yoff, r.right, yoff + item_height };
-            if ((int)i == selected) {
-                HBRUSH sel = CreateSolidBrush(RGB(180,200,240));
-                FillRect(hdc, &tr, sel);
-                DeleteObject(sel);
+        for (size_t i = top_row; i < n && yoff < r.bottom; ++i) {
+            RECT tr = { r.left + 2, yoff, right, std::min<LONG>(yoff + item_height, r.bottom) };
+            if (row_selected(i)) {
+                FillRect(hdc, &tr, palette().brush(theme().selection));
             }
-            DrawTextA(hdc, items[i].c_str(), (int)items[i].size(), &tr, DT_SINGLELINE | DT_LEFT | DT_VCENTER);
+            std::string_view s = row(i);
+            DrawTextA(hdc, s.data(), (int)s.size(), &tr, DT_SINGLELINE | DT_LEFT | DT_VCENTER | DT_NOPREFIX);
             yoff += item_height;
-            if (yoff > r.bottom) break;
         }
         SelectObject(hdc, hOld);
-        DeleteObject(hFont);
+        if (scroll) {
+            // proportional thumb on the right edge
+            int track = geom.h - 2;
+            int thumb = std::max(12, (int)((double)track * visible_rows() / n));
+            int ty = r.top + 1 + (int)((double)(track - thumb) * top_row / std::max<size_t>(1, max_top()));
+            RECT th = { r.right - kScrollbarW, ty, r.right - 1, ty + thumb };
+            FillRect(hdc, &th, palette().brush(theme().scrollbar));
+        }
     }
+
     void on_click_internal(int x,int y) override {
-        int idx = y / item_height;
-        if (idx >= 0 && idx < (int)items.size()) {
-            selected = idx;
-            if (on_change) on_change(this);
-            mark_dirty();
+        if (x >= geom.w - kScrollbarW && count() > visible_rows()) {
+            dragging_thumb_ = true;
+            on_drag(x, y);
+            return;
         }
+        size_t idx = top_row + (size_t)std::max(0, y) / std::max(1, item_height);
+        if (y >= 0 && idx < count()) on_row_click(idx);
+    }
+    void on_drag(int x, int y) override {
+        if (!dragging_thumb_) return;
+        double t = std::clamp((double)y / std::max(1, geom.h), 0.0, 1.0);
+        scroll_to((size_t)std::llround(t * max_top()));
     }
+    void on_release(int x, int y) override { dragging_thumb_ = false; }
+    void on_wheel(int delta) override {
+        // 3 rows per notch; fine-grained wheels and touchpads send fractions of a notch, so keep
+        // the leftover in wheel_accum_ (rows * WHEEL_DELTA) and reset it on a direction change
+        long long d = -(long long)delta * 3;
+        if ((d < 0) != (wheel_accum_ < 0)) wheel_accum_ = 0;
+        wheel_accum_ += d;
+        long long step = wheel_accum_ / WHEEL_DELTA;
+        if (!step) return;
+        wheel_accum_ -= step * WHEEL_DELTA;
+        long long top = (long long)top_row + step;
+        scroll_to((size_t)std::max(0LL, top));
+    }
+
+private:
+    bool dragging_thumb_ = false;
+    long long wheel_accum_ = 0;
 };
 
-// ---------- Multi-select ListBox ----------
-struct MultiListBox : Widget {
-    std::vector<std::string> items;
-    std::vector<int> selected_indices; // multi-selection
-    int item_height = 20;
-    void draw(HDC hdc) override {
-        RECT r{geom.x, geom.y, geom.x + geom.w, geom.y + geom.h};
-        HBRUSH bg = CreateSolidBrush(RGB(255,255,255));
-        FillRect(hdc, &r, bg); DeleteObject(bg);
-        Rectangle(hdc, r.left, r.top, r.right, r.bottom);
-        HFONT hFont = make_font(hdc);
-        HFONT hOld = (HFONT)SelectObject(hdc, hFont);
-        int yoff = r.top;
-        for (size_t i=0;i<items.size();++i) {
-            RECT tr = { r.left + 2, yoff, r.right, yoff + item_height };
-            if (std::find(selected_indices.begin(), selected_indices.end(), (int)i) != selected_indices.end()) {
-                HBRUSH sel = CreateSolidBrush(RGB(180,200,240));
-                FillRect(hdc, &tr, sel);
-                DeleteObject(sel);
-            }
-            DrawTextA(hdc, items[i].c_str(), (int)items[i].size(), &tr, DT_SINGLELINE | DT_LEFT | DT_VCENTER);
-            yoff += item_height;
-            if (yoff > r.bottom) break;
-        }
-        SelectObject(hdc, hOld);
-        DeleteObject(hFont);
+// ---------- ListBox (single-select) ----------
+struct ListBox : ListBase {
+    int selected = -1;
+    bool row_selected(size_t i) const override { return (int)i == selected; }
+    void on_row_click(size_t i) override {
+        selected = (int)i;
+        if (on_change) on_change(this);
+        mark_dirty();
     }
-    void on_click_internal(int x,int y) override {
-        int idx = y / item_height;
-        if (idx >= 0 && idx < (int)items.size()) {
-            auto it = std::find(selected_indices.begin(), selected_indices.end(), idx);
+};
+
+// ---------- Multi-select ListBox ----------
+struct MultiListBox : ListBase {
+    std::vector<int> selected_indices; // selected rows in click order; callers may edit it directly
+
+    bool is_selected(size_t i) const { sync(); return selection_.test(i); }
+    void set_selected(size_t i, bool on) {
+        sync();
+        if (selection_.test(i) == on) return;
+        selection_.set(i, on);
+        if (on) {
+            selected_indices.push_back((int)i);
+            synced_.push_back((int)i);
+        } else {
+            auto it = std::find(selected_indices.begin(), selected_indices.end(), (int)i);
             if (it != selected_indices.end()) selected_indices.erase(it);
-            else selected_indices.push_back(idx);
-            if (on_change) on_change(this);
-            mark_dirty();
+            synced_ = selected_indices;
         }
+        mark_dirty();
+    }
+    void clear_selection() { selected_indices.clear(); synced_.clear(); selection_.clear(); mark_dirty(); }
+
+    void draw(HDC hdc) override {
+        sync();
+        ListBase::draw(hdc);
+    }
+    bool row_selected(size_t i) const override { return selection_.test(i); } // draw() synced already
+    void on_row_click(size_t i) override {
+        set_selected(i, !is_selected(i));
+        if (on_change) on_change(this);
+    }
+
+private:
+    // O(1) row test derived from selected_indices; rebuilt whenever the vector differs from the
+    // copy it was last built from, so direct edits of selected_indices are always picked up
+    mutable RowSet selection_;
+    mutable std::vector<int> synced_;
+
+    void sync() const {
+        if (synced_ == selected_indices) return;
+        synced_ = selected_indices;
+        selection_.clear();
+        for (int i : selected_indices) if (i >= 0) selection_.set((size_t)i, true);
     }
 };
 
@@ -455,20 +1177,24 @@ struct ComboBox : Widget {
     bool expanded = false;
     int option_height = 20;
 
+    RECT bounds() const override {
+        RECT r = Widget::bounds();
+        if (expanded) r.bottom += (int)options.size() * option_height;
+        return r;
+    }
+
     void draw(HDC hdc) override {
         RECT r{geom.x, geom.y, geom.x + geom.w, geom.y + geom.h};
-        HBRUSH bg = CreateSolidBrush(RGB(255,255,255));
-        FillRect(hdc, &r, bg); DeleteObject(bg);
-        Rectangle(hdc, r.left, r.top, r.right, r.bottom);
+        FillRect(hdc, &r, palette().brush(theme().field));
+        draw_border(hdc, r);
 
-        HFONT hFont = make_font(hdc);
+        HFONT hFont = font(hdc);
         HFONT hOld = (HFONT)SelectObject(hdc, hFont);
         if (selected >= 0 && selected < (int)options.size()) {
             RECT tr = r; tr.left += 4;
             DrawTextA(hdc, options[selected].c_str(), (int)options[selected].size(), &tr, DT_SINGLELINE | DT_LEFT | DT_VCENTER);
         }
         SelectObject(hdc, hOld);
-        DeleteObject(hFont);
 
         // arrow
         POINT pts[3] = { {r.right-14, r.top + (r.bottom - r.top)/2 - 4}, {r.right-6, r.top + (r.bottom - r.top)/2 - 4}, {r.right-10, r.top + (r.bottom - r.top)/2 + 2} };
@@ -476,10 +1202,8 @@ struct ComboBox : Widget {
 
         if (expanded) {
             RECT ext = {r.left, r.bottom, r.right, r.bottom + (int)options.size()*option_height};
-            HBRUSH bg2 = CreateSolidBrush(RGB(240,240,240));
-            FillRect(hdc, &ext, bg2); DeleteObject(bg2);
-            HFONT hFont2 = make_font(hdc);
-            HFONT hOld2 = (HFONT)SelectObject(hdc, hFont2);
+            FillRect(hdc, &ext, palette().brush(theme().popup));
+            HFONT hOld2 = (HFONT)SelectObject(hdc, hFont);
             int yoff = r.bottom;
             for (size_t i=0;i<options.size();++i) {
                 RECT tr = { r.left + 4, yoff, r.right, yoff + option_height };
@@ -487,7 +1211,6 @@ struct ComboBox : Widget {
                 yoff += option_height;
             }
             SelectObject(hdc, hOld2);
-            DeleteObject(hFont2);
         }
     }
 
@@ -502,6 +1225,25 @@ struct ComboBox : Widget {
         }
         mark_dirty();
     }
+
+    // press-drag-release picking: hover highlights, release commits
+    void on_drag(int x, int y) override {
+        if (!expanded) return;
+        int idx = (y - geom.h) / option_height;
+        if (idx >= 0 && idx < (int)options.size()) {
+            selected = idx; // visual hover
+            mark_dirty();
+        }
+    }
+    void on_release(int x, int y) override {
+        if (!expanded) return;
+        int idx = (y - geom.h) / option_height;
+        if (idx >= 0 && idx < (int)options.size()) {
+            selected = idx;
+            if (on_change) on_change(this);
+        }
+        expanded = false;
+    }
 };
 
 // ---------- ProgressBar (determinate + indeterminate / marquee) ----------
@@ -522,15 +1264,28 @@ struct ProgressBar : Widget {
     void set_value(int v) {
         v = std::clamp(v, min, max);
         target = (float)v;
+        mark_dirty();
+    }
+
+    bool is_animating() const override { return indeterminate || std::fabs(target - fvalue) > 0.001f; }
+
+    void animate(float dt, float alpha) override {
+        if (indeterminate) {
+            float speed = 0.6f; // cycles per second
+            marquee_pos += speed * dt;
+            marquee_pos = std::fmod(marquee_pos, 1.0f);
+            mark_dirty();
+        } else {
+            ease_value(fvalue, target, value, alpha);
+        }
     }
 
     void draw(HDC hdc) override {
         RECT r{geom.x, geom.y, geom.x + geom.w, geom.y + geom.h};
         // background
-        HBRUSH bg = CreateSolidBrush(RGB(230,230,230));
-        FillRect(hdc, &r, bg); DeleteObject(bg);
+        FillRect(hdc, &r, palette().brush(theme().progress_bg));
         // border
-        Rectangle(hdc, r.left, r.top, r.right, r.bottom);
+        draw_border(hdc, r);
 
         if (indeterminate) {
             // draw moving marquee block
@@ -542,7 +1297,7 @@ struct ProgressBar : Widget {
             int by = geom.y + 2;
             int bw = blockW;
             RECT br = { bx, by, bx + bw, geom.y + geom.h - 2 };
-            HBRUSH fill = CreateSolidBrush(RGB(100,160,240));
+            HBRUSH fill = palette().brush(theme().marquee);
             // draw primary and wrap
             RECT clipped = br;
             if (clipped.left < geom.x) clipped.left = geom.x;
@@ -555,14 +1310,11 @@ struct ProgressBar : Widget {
             if (clipped2.right > geom.x + geom.w) clipped2.right = geom.x + geom.w;
             if (clipped2.right > clipped2.left) FillRect(hdc, &clipped2, fill);
 
-            DeleteObject(fill);
-
-            HFONT hFont = make_font(hdc);
+            HFONT hFont = font(hdc);
             HFONT hOld = (HFONT)SelectObject(hdc, hFont);
             SetBkMode(hdc, TRANSPARENT);
             RECT tr = r; DrawTextA(hdc, "Loading...", 10, &tr, DT_SINGLELINE | DT_CENTER | DT_VCENTER);
             SelectObject(hdc, hOld);
-            DeleteObject(hFont);
         } else {
             int range = std::max(1, max - min);
             float norm = (fvalue - min) / (float)range;
@@ -570,42 +1322,100 @@ struct ProgressBar : Widget {
             int fillw = (int)std::round(norm * geom.w);
             RECT fr = { geom.x + 1, geom.y + 1, geom.x + fillw, geom.y + geom.h - 1 };
             if (fr.right > fr.left) {
-                HBRUSH fill = CreateSolidBrush(RGB(100,180,120));
-                FillRect(hdc, &fr, fill);
-                DeleteObject(fill);
+                FillRect(hdc, &fr, palette().brush(theme().progress_fill));
             }
 
             int percent = (int)std::round(norm * 100.0f);
             std::ostringstream ss; ss << percent << "%";
-            HFONT hFont = make_font(hdc);
+            HFONT hFont = font(hdc);
             HFONT hOld = (HFONT)SelectObject(hdc, hFont);
             SetBkMode(hdc, TRANSPARENT);
             RECT tr = r; DrawTextA(hdc, ss.str().c_str(), (int)ss.str().size(), &tr, DT_SINGLELINE | DT_CENTER | DT_VCENTER);
             SelectObject(hdc, hOld);
-            DeleteObject(hFont);
         }
     }
 };
 
+// ---------- Hit-test grid ----------
+// Uniform grid over widget rects: a point query only looks at the widgets filed
+// under one cell instead of walking every widget. Each widget remembers the rect
+// it is filed under (Widget::hit_rect), so moving one widget is an O(cells) update.
+class HitGrid {
+public:
+    static constexpr int kCell = 64; // pixels per cell side
+
+    void reset(int w, int h) {
+        cols_ = std::max(1, (w + kCell - 1) / kCell);
+        rows_ = std::max(1, (h + kCell - 1) / kCell);
+        cells_.assign((size_t)cols_ * rows_, {});
+    }
+
+    void insert(Widget *w) {
+        w->hit_rect = RECT{w->geom.x, w->geom.y, w->geom.x + w->geom.w, w->geom.y + w->geom.h};
+        for_cells(w->hit_rect, [&](std::vector<Widget*> &c) { c.push_back(w); });
+    }
+
+    void remove(Widget *w) {
+        for_cells(w->hit_rect, [&](std::vector<Widget*> &c) {
+            auto it = std::find(c.begin(), c.end(), w);
+            if (it != c.end()) { *it = c.back(); c.pop_back(); }
+        });
+    }
+
+    // refile a widget whose geometry may have changed
+    void update(Widget *w) {
+        RECT r{w->geom.x, w->geom.y, w->geom.x + w->geom.w, w->geom.y + w->geom.h};
+        if (EqualRect(&r, &w->hit_rect)) return;
+        remove(w);
+        insert(w);
+    }
+
+    // topmost shown widget whose geom contains (x, y)
+    Widget* query(int x, int y) const {
+        if (cells_.empty()) return nullptr;
+        int cx = std::clamp(x / kCell, 0, cols_ - 1), cy = std::clamp(y / kCell, 0, rows_ - 1);
+        Widget *best = nullptr;
+        for (Widget *w : cells_[(size_t)cy * cols_ + cx]) {
+            if (best && w->hit_rank < best->hit_rank) continue;
+            if (x >= w->geom.x && x < w->geom.x + w->geom.w &&
+                y >= w->geom.y && y < w->geom.y + w->geom.h && w->shown()) best = w;
+        }
+        return best;
+    }
+
+private:
+    int cols_ = 0, rows_ = 0;
+    std::vector<std::vector<Widget*>> cells_;
+
+    // visit the cells overlapping r; rects beyond the client area are filed under the edge cells
+    template<typename F> void for_cells(const RECT &r, F f) {
+        if (cells_.empty() || r.right <= r.left || r.bottom <= r.top) return;
+        int x0 = std::clamp((int)r.left / kCell, 0, cols_ - 1), x1 = std::clamp((int)(r.right - 1) / kCell, 0, cols_ - 1);
+        int y0 = std::clamp((int)r.top / kCell, 0, rows_ - 1), y1 = std::clamp((int)(r.bottom - 1) / kCell, 0, rows_ - 1);
+        for (int cy = y0; cy <= y1; ++cy)
+            for (int cx = x0; cx <= x1; ++cx) f(cells_[(size_t)cy * cols_ + cx]);
+    }
+};
+
 // ---------- Window (host) ----------
 class Window {
 public:
     Window(int width, int height, const char* title) :
         width_(width), height_(height), title_(title)
     {
+        damage_rgn_ = CreateRectRgn(0, 0, 0, 0);
         register_class();
         create_window();
         last_tick_ = std::chrono::steady_clock::now();
-        // start periodic timer for smooth redraw and animations (~60Hz)
-        if (hwnd_) {
-            SetTimer(hwnd_, kRefreshTimerId, kRefreshPeriodMs, NULL);
-        }
+        // the ~60Hz animation timer only runs while some widget is animating (see schedule_animation)
     }
     ~Window() {
         if (hwnd_) {
-            KillTimer(hwnd_, kRefreshTimerId);
+            stop_timers();
             DestroyWindow(hwnd_);
         }
+        release_back_buffer();
+        if (damage_rgn_) DeleteObject(damage_rgn_);
         UnregisterClassA(wc_.lpszClassName, wc_.hInstance);
     }
 
@@ -613,7 +1423,7 @@ public:
     std::shared_ptr<Label> make_label(const std::string &txt){ auto p = std::make_shared<Label>(txt); register_widget(p); return p; }
     std::shared_ptr<Entry> make_entry(const std::string &txt){ auto p = std::make_shared<Entry>(txt); register_widget(p); return p; }
     std::shared_ptr<Button> make_button(const std::string &txt){ auto p = std::make_shared<Button>(txt); register_widget(p); return p; }
-    std::shared_ptr<Canvas> make_canvas(int w,int h){ auto p = std::make_shared<Canvas>(w,h); register_widget(p); return p; }
+    std::shared_ptr<Canvas> make_canvas(int w,int h, CanvasFormat fmt = CanvasFormat::BGR24){ auto p = std::make_shared<Canvas>(w,h,fmt); register_widget(p); return p; }
     std::shared_ptr<Frame> make_frame(){ auto p = std::make_shared<Frame>(); register_widget(p); return p; }
     std::shared_ptr<Checkbox> make_checkbox(const std::string &txt=""){ auto p = std::make_shared<Checkbox>(txt); register_widget(p); return p; }
     std::shared_ptr<RadioButton> make_radiobutton(const std::string &txt="", int gid=0){ auto p = std::make_shared<RadioButton>(txt,gid); register_widget(p); return p; }
@@ -643,7 +1453,39 @@ public:
         w->geom.x = x; w->geom.y = y;
         w->parent = nullptr;
         w->packed = false;
-        InvalidateRect(hwnd_, NULL, FALSE);
+        w->host = this;
+        w->mark_dirty(); // damages both the old and the new position, and refiles it in the hit grid
+    }
+
+    // topmost visible widget under a client point, Frame children included
+    Widget* hit_test(int x, int y) {
+        if (hit_stale_) rebuild_hit_grid();
+        return hit_grid_.query(x, y);
+    }
+
+    // keep a widget's hit-grid entry in step with its geometry
+    void reindex(Widget *w) {
+        if (!hit_stale_ && w->hit_rank >= 0) hit_grid_.update(w);
+    }
+
+    // membership changed (new widget / frame child): rebuild the grid on the next query
+    void invalidate_hit_grid() { hit_stale_ = true; }
+
+    // add a widget to the animation set and start the refresh timer if it was idle
+    void schedule_animation(Widget *w) {
+        if (!w || w->anim_scheduled) return;
+        w->anim_scheduled = true;
+        animating_.push_back(w);
+        if (!anim_timer_on_ && hwnd_) {
+            last_tick_ = std::chrono::steady_clock::now(); // don't count the idle time as one huge step
+            SetTimer(hwnd_, kRefreshTimerId, kRefreshPeriodMs, NULL);
+            anim_timer_on_ = true;
+        }
+    }
+
+    // add a client rect to the window's damage region; the next WM_PAINT repaints only damaged widgets
+    void damage(const RECT &r) {
+        if (hwnd_ && r.right > r.left && r.bottom > r.top) InvalidateRect(hwnd_, &r, FALSE);
     }
 
     void measure() {
@@ -661,18 +1503,74 @@ public:
     }
 
     HWND hwnd() const { return hwnd_; }
+    const FrameStats& frame_stats() const { return stats_; }
+
+    // Draw every visible widget that overlaps dc's clip region, in paint order, and record what
+    // was covered for the next damage pass. WM_PAINT uses it on the back buffer; headless code
+    // (see softgui_bench.cpp) can call it on any memory DC. Returns the number of widgets drawn.
+    static unsigned render(HDC dc, const std::vector<WidgetPtr> &widgets) {
+        unsigned drawn = 0;
+        for (auto &wptr : widgets) {
+            if (!wptr) continue;
+            RECT wb = wptr->bounds();
+            if (!RectVisible(dc, &wb)) continue;
+            if (wptr->visible) {
+                SOFTGUI_PROF_SCOPE(typeid(*wptr).name());
+                wptr->draw(dc);
+                wptr->painted = wb;
+                ++drawn;
+            } else {
+                wptr->painted = RECT{0,0,0,0};
+            }
+            wptr->dirty = false;
+        }
+        return drawn;
+    }
+
+    // Corner overlay with frame time, fps, widgets drawn, GDI allocations and input latency,
+    // refreshed twice a second. Needs SOFTGUI_PROFILE; a no-op otherwise.
+    void set_profiler_overlay(bool on) {
+#ifdef SOFTGUI_PROFILE
+        if (on == overlay_on_) return;
+        overlay_on_ = on;
+        ov_ = OverlayAccum{};
+        ov_.since_us = prof::now_us();
+        if (on) SetTimer(hwnd_, kOverlayTimerId, kOverlayPeriodMs, NULL);
+        else KillTimer(hwnd_, kOverlayTimerId);
+        damage(overlay_rect());
+#else
+        (void)on;
+#endif
+    }
 
     void set_title(const char* t) { title_ = t; SetWindowTextA(hwnd_, t); }
+
+    // Queue fn to run on the UI thread; safe to call from any thread, e.g. to apply a worker's
+    // results to widgets. Tasks still queued when the window is destroyed are dropped.
+    void post(std::function<void()> fn) {
+        std::lock_guard<std::mutex> lk(post_mu_);
+        posted_.push_back(std::move(fn));
+        if (post_pending_ || !hwnd_) return; // one message per batch
+        // a failed post (full message queue) leaves the flag clear so the next post() retries
+        post_pending_ = PostMessageA(hwnd_, WM_SOFTGUI_POST, 0, 0) != FALSE;
+    }
     void resize(int w,int h) { width_=w; height_=h; SetWindowPos(hwnd_, NULL,0,0,w,h, SWP_NOMOVE|SWP_NOZORDER); recompute_layout(); InvalidateRect(hwnd_, NULL, FALSE); }
 
 private:
     static constexpr UINT_PTR kRefreshTimerId = 0x1001;
     static constexpr int kRefreshPeriodMs = 16; // ~60Hz
+    static constexpr UINT_PTR kCaretTimerId = 0x1002;
+    static constexpr int kCaretPeriodMs = 500;
+    static constexpr UINT_PTR kOverlayTimerId = 0x1003;
+    static constexpr int kOverlayPeriodMs = 500;
 
     int width_, height_;
     std::string title_;
     HWND hwnd_ = NULL;
     WNDCLASSEXA wc_{};
+    std::mutex post_mu_;
+    std::deque<std::function<void()>> posted_; // Window::post queue, drained on WM_SOFTGUI_POST
+    bool post_pending_ = false;                // a WM_SOFTGUI_POST is queued (guarded by post_mu_)
     HINSTANCE hInst_ = GetModuleHandleA(NULL);
 
     // top-level widget storage (we own shared_ptr)
@@ -680,22 +1578,171 @@ private:
     // for pack-based layout we consider top-level ordered list
     std::vector<WidgetPtr> pack_order_;
 
-    // focused entry handling
-    std::shared_ptr<Entry> focused_entry_;
+    // focused entry handling (raw pointer into a widget owned by widgets_ or a frame)
+    Entry* focused_entry_ = nullptr;
+
+    // spatial index for mouse routing; rebuilt lazily after membership or size changes
+    HitGrid hit_grid_;
+    bool hit_stale_ = true;
 
     // capture dragging widget (raw pointer into a widget owned in widgets_)
     Widget* capture_widget_ = nullptr;
 
     // timing for animations
     std::chrono::steady_clock::time_point last_tick_;
+    // widgets needing ticks (raw pointers into widgets owned by widgets_ or their frames)
+    std::vector<Widget*> animating_;
+    bool anim_timer_on_ = false;
+
+    // damage tracking: update region fetched at WM_PAINT and its rect list (reused across frames)
+    HRGN damage_rgn_ = NULL;
+    std::vector<char> damage_data_;
+    static constexpr DWORD kMaxBlitRects = 32; // beyond this, blit the bounding box instead
+
+    // persistent back buffer, (re)allocated only from WM_SIZE when the client area outgrows it
+    HDC back_dc_ = NULL;
+    HBITMAP back_bm_ = NULL;
+    HGDIOBJ back_old_ = NULL;
+    int back_w_ = 0, back_h_ = 0;
+
+    FrameStats stats_;
+
+#ifdef SOFTGUI_PROFILE
+    // profiler overlay: frames are folded into ov_ and shown as the snapshot ov_shown_ on each tick
+    struct OverlayAccum {
+        int64_t since_us = 0;
+        unsigned frames = 0;
+        double sum_ms = 0, max_ms = 0, latency_ms = 0;
+        unsigned widgets = 0;
+        unsigned long gdi_allocs = 0;
+    };
+    struct OverlayShown { double fps = 0, avg_ms = 0, max_ms = 0, latency_ms = 0; unsigned widgets = 0; unsigned long gdi_allocs = 0; };
+    bool overlay_on_ = false;
+    OverlayAccum ov_;
+    OverlayShown ov_shown_;
+    int64_t input_t0_us_ = 0; // arrival of the oldest input not yet answered by a frame (0 = none)
+#endif
 
     // register widget
     void register_widget(WidgetPtr w) {
         if (!w) return;
+        w->host = this;
         widgets_.push_back(w);
         pack_order_.push_back(w);
+        hit_stale_ = true;
+        if (w->is_animating()) schedule_animation(w.get()); // e.g. an indeterminate ProgressBar
+    }
+
+    void rebuild_hit_grid() {
+        hit_grid_.reset(width_, height_);
+        int rank = 0;
+        // paint order: each frame's children right after the frame itself
+        std::function<void(Widget*)> add = [&](Widget *w) {
+            w->hit_rank = rank++;
+            hit_grid_.insert(w);
+            if (Frame *f = dynamic_cast<Frame*>(w))
+                for (auto &c : f->children) add(c.get());
+        };
+        for (auto &w : widgets_) add(w.get());
+        hit_stale_ = false;
+    }
+
+    // caret blink runs on its own slow timer, only while an Entry has focus
+    void start_caret_blink() {
+        if (!focused_entry_ || !hwnd_) return;
+        focused_entry_->caret_visible = true;
+        SetTimer(hwnd_, kCaretTimerId, kCaretPeriodMs, NULL); // re-arming restarts the period
+    }
+
+    void stop_caret_blink() {
+        if (hwnd_) KillTimer(hwnd_, kCaretTimerId);
+    }
+
+    void tick_caret() {
+        Entry *en = focused_entry_;
+        if (en && en->focused) {
+            en->caret_visible = !en->caret_visible;
+            en->repaint();
+        } else {
+            // focus dropped by the entry itself (e.g. Enter)
+            if (en && en->caret_visible) { en->caret_visible = false; en->repaint(); }
+            stop_caret_blink();
+        }
     }
 
+    void stop_timers() {
+        KillTimer(hwnd_, kRefreshTimerId);
+        anim_timer_on_ = false;
+        stop_caret_blink();
+#ifdef SOFTGUI_PROFILE
+        KillTimer(hwnd_, kOverlayTimerId);
+#endif
+    }
+
+#ifdef SOFTGUI_PROFILE
+    // top-right corner box the overlay draws into, in client coordinates
+    RECT overlay_rect() const {
+        int dpi = 96;
+        if (hwnd_) { HDC wdc = GetDC(hwnd_); dpi = GetDeviceCaps(wdc, LOGPIXELSY); ReleaseDC(hwnd_, wdc); }
+        int w = MulDiv(210, dpi, 96), h = MulDiv(92, dpi, 96), m = MulDiv(6, dpi, 96);
+        return RECT{ width_ - w - m, m, width_ - m, m + h };
+    }
+
+    // stamp the arrival of input the user is waiting on; GetMessageTime adds the time spent queued
+    void note_input() {
+        if (input_t0_us_) return;
+        DWORD queued_ms = GetTickCount() - (DWORD)GetMessageTime();
+        if (queued_ms > 1000) queued_ms = 0; // synthesized / stale message times
+        input_t0_us_ = prof::now_us() - (int64_t)queued_ms * 1000;
+    }
+
+    // fold a finished frame into the overlay, unless it only repainted the overlay itself
+    void overlay_frame(const RECT &damage_box) {
+        if (!overlay_on_) return;
+        RECT orc = overlay_rect(), u;
+        UnionRect(&u, &orc, &damage_box);
+        if (EqualRect(&u, &orc)) return;
+        ov_.frames++;
+        ov_.sum_ms += stats_.frame_ms;
+        ov_.max_ms = std::max(ov_.max_ms, stats_.frame_ms);
+        ov_.widgets = stats_.widgets_drawn;
+        ov_.gdi_allocs += stats_.gdi_allocs;
+        if (stats_.input_latency_ms > 0) ov_.latency_ms = std::max(ov_.latency_ms, stats_.input_latency_ms);
+    }
+
+    void tick_overlay() {
+        int64_t now = prof::now_us();
+        double secs = std::max(1e-6, (now - ov_.since_us) / 1e6);
+        ov_shown_.fps = ov_.frames / secs;
+        ov_shown_.avg_ms = ov_.frames ? ov_.sum_ms / ov_.frames : 0.0;
+        ov_shown_.max_ms = ov_.max_ms;
+        ov_shown_.latency_ms = ov_.latency_ms;
+        ov_shown_.widgets = ov_.widgets;
+        ov_shown_.gdi_allocs = ov_.gdi_allocs;
+        ov_ = OverlayAccum{};
+        ov_.since_us = now;
+        damage(overlay_rect());
+    }
+
+    void draw_overlay(HDC dc) {
+        RECT r = overlay_rect();
+        if (!RectVisible(dc, &r)) return;
+        FillRect(dc, &r, palette().brush(Color(16, 16, 16)));
+        draw_border(dc, r);
+        char buf[256];
+        snprintf(buf, sizeof(buf),
+                 "frame %6.2f ms  max %6.2f\nfps   %6.1f\nwidgets drawn %u\ngdi new %lu  handles %lu\ninput %6.1f ms",
+                 ov_shown_.avg_ms, ov_shown_.max_ms, ov_shown_.fps, ov_shown_.widgets,
+                 ov_shown_.gdi_allocs, (unsigned long)stats_.gdi_handles, ov_shown_.latency_ms);
+        HFONT hOld = (HFONT)SelectObject(dc, font_cache().get("Consolas", 9, GetDeviceCaps(dc, LOGPIXELSY)));
+        SetBkMode(dc, TRANSPARENT);
+        SetTextColor(dc, RGB(120, 230, 120));
+        RECT tr{ r.left + 6, r.top + 4, r.right - 4, r.bottom - 4 };
+        DrawTextA(dc, buf, -1, &tr, DT_LEFT | DT_TOP | DT_NOPREFIX);
+        SelectObject(dc, hOld);
+    }
+#endif
+
     void register_class() {
         ZeroMemory(&wc_, sizeof(wc_));
         wc_.cbSize = sizeof(WNDCLASSEXA);
@@ -723,8 +1770,31 @@ private:
         UpdateWindow(hwnd_);
     }
 
+    void ensure_back_buffer(int w, int h) {
+        if (back_dc_ && w <= back_w_ && h <= back_h_) return;
+        release_back_buffer();
+        if (w <= 0 || h <= 0 || !hwnd_) return;
+        HDC wdc = GetDC(hwnd_);
+        back_dc_ = CreateCompatibleDC(wdc);
+        back_bm_ = CreateCompatibleBitmap(wdc, w, h);
+        gdi::created() += 2;
+        ReleaseDC(hwnd_, wdc);
+        back_old_ = SelectObject(back_dc_, back_bm_);
+        back_w_ = w; back_h_ = h;
+    }
+
+    void release_back_buffer() {
+        if (!back_dc_) return;
+        SelectObject(back_dc_, back_old_);
+        DeleteObject(back_bm_);
+        DeleteDC(back_dc_);
+        back_dc_ = NULL; back_bm_ = NULL; back_old_ = NULL;
+        back_w_ = back_h_ = 0;
+    }
+
     // layout recompute (very simple pack)
     void recompute_layout() {
+        SOFTGUI_PROF_SCOPE("recompute_layout");
         int cur_top = 10, cur_left = 10;
         for (auto &w : pack_order_) {
             if (!w->packed) continue;
@@ -751,6 +1821,7 @@ private:
                 w->geom.x = cur_left + o.padx;
                 cur_left += w->geom.w + o.padx + 8;
             }
+            reindex(w.get());
         }
     }
 
@@ -769,207 +1840,166 @@ private:
         return DefWindowProcA(hwnd, msg, wParam, lParam);
     }
 
-    // helper: update animations (sliders, progress bars) each tick
+    // run everything posted so far; tasks posted meanwhile arrive with the next message
+    void run_posted() {
+        SOFTGUI_PROF_SCOPE("run_posted");
+        std::deque<std::function<void()>> batch;
+        {
+            std::lock_guard<std::mutex> lk(post_mu_);
+            batch.swap(posted_);
+            post_pending_ = false;
+        }
+        for (auto &fn : batch) if (fn) fn();
+    }
+
+    // helper: update animations (sliders, progress bars) each tick; only visits the active set
     void tick_animate() {
-        bool need_invalidate = false;
+        SOFTGUI_PROF_SCOPE("tick_animate");
         // smoothing factor computed from delta time (frame-rate independent)
         auto now = std::chrono::steady_clock::now();
         float dt = std::chrono::duration_cast<std::chrono::duration<float>>(now - last_tick_).count();
         last_tick_ = now;
         float alpha = std::min(1.0f, dt * 12.0f); // roughly eases over ~0.08s
 
-        for (auto &wptr : widgets_) {
-            if (!wptr) continue;
-            // HSlider
-            if (auto hs = dynamic_cast<HSlider*>(wptr.get())) {
-                float diff = hs->target - hs->fvalue;
-                if (std::fabs(diff) > 0.001f) {
-                    hs->fvalue += diff * alpha;
-                    // snap if very close
-                    if (std::fabs(hs->target - hs->fvalue) < 0.001f) hs->fvalue = hs->target;
-                    int newv = (int)std::lround(hs->fvalue);
-                    if (newv != hs->value) {
-                        hs->value = newv;
-                        if (hs->on_change) hs->on_change(hs);
-                    }
-                    hs->mark_dirty();
-                    need_invalidate = true;
-                }
-            }
-            // VSlider
-            if (auto vs = dynamic_cast<VSlider*>(wptr.get())) {
-                float diff = vs->target - vs->fvalue;
-                if (std::fabs(diff) > 0.001f) {
-                    vs->fvalue += diff * alpha;
-                    if (std::fabs(vs->target - vs->fvalue) < 0.001f) vs->fvalue = vs->target;
-                    int newv = (int)std::lround(vs->fvalue);
-                    if (newv != vs->value) {
-                        vs->value = newv;
-                        if (vs->on_change) vs->on_change(vs);
-                    }
-                    vs->mark_dirty();
-                    need_invalidate = true;
-                }
-            }
-            // ProgressBar
-            if (auto pb = dynamic_cast<ProgressBar*>(wptr.get())) {
-                if (pb->indeterminate) {
-                    float speed = 0.6f; // cycles per second
-                    pb->marquee_pos += speed * dt;
-                    pb->marquee_pos = std::fmod(pb->marquee_pos, 1.0f);
-                    pb->mark_dirty();
-                    need_invalidate = true;
-                } else {
-                    float diff = pb->target - pb->fvalue;
-                    if (std::fabs(diff) > 0.001f) {
-                        pb->fvalue += diff * alpha;
-                        if (std::fabs(pb->target - pb->fvalue) < 0.001f) pb->fvalue = pb->target;
-                        int newv = (int)std::lround(pb->fvalue);
-                        if (newv != pb->value) {
-                            pb->value = newv;
-                            if (pb->on_change) pb->on_change(pb);
-                        }
-                        pb->mark_dirty();
-                        need_invalidate = true;
-                    }
-                }
-            }
-            // caret blink: independent timer toggles caret for entries
-            if (auto en = dynamic_cast<Entry*>(wptr.get())) {
-                if (en->focused) {
-                    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - en->last_blink).count();
-                    if (ms > 500) {
-                        en->caret_visible = !en->caret_visible;
-                        en->last_blink = now;
-                        en->mark_dirty();
-                        need_invalidate = true;
-                    }
-                } else {
-                    // ensure caret hidden when not focused
-                    if (en->caret_visible) { en->caret_visible = false; en->mark_dirty(); need_invalidate = true; }
-                }
-            }
+        // index loop: on_change callbacks may schedule more widgets while we iterate
+        for (size_t i = 0; i < animating_.size(); ++i) {
+            animating_[i]->animate(dt, alpha);
         }
 
-        if (need_invalidate && hwnd_) {
-            InvalidateRect(hwnd_, NULL, FALSE);
+        // drop settled widgets; stop ticking once nothing is left
+        animating_.erase(std::remove_if(animating_.begin(), animating_.end(), [](Widget *w) {
+            if (w->is_animating()) return false;
+            w->anim_scheduled = false;
+            return true;
+        }), animating_.end());
+        if (animating_.empty() && anim_timer_on_) {
+            KillTimer(hwnd_, kRefreshTimerId);
+            anim_timer_on_ = false;
         }
     }
 
     // main instance wndproc with double-buffered painting, mouse capture, and timer-driven animation
     LRESULT wndproc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+#ifdef SOFTGUI_PROFILE
+        // bare hover moves repaint nothing, so they would only inflate the latency figure
+        if ((msg >= WM_KEYFIRST && msg <= WM_KEYLAST) ||
+            (msg >= WM_MOUSEFIRST && msg <= WM_MOUSELAST && (msg != WM_MOUSEMOVE || capture_widget_))) note_input();
+#endif
         switch (msg) {
             case WM_PAINT: {
+#ifdef SOFTGUI_PROFILE
+                prof::Scope paint_scope("WM_PAINT");
+                int64_t paint_t0 = prof::now_us();
+#endif
+                // grab the damage region before BeginPaint validates it
+                int rgn_type = GetUpdateRgn(hwnd, damage_rgn_, FALSE);
                 PAINTSTRUCT ps;
                 HDC hdc = BeginPaint(hwnd, &ps);
+                if (rgn_type == NULLREGION || rgn_type == ERROR) SetRectRgn(damage_rgn_, ps.rcPaint.left, ps.rcPaint.top, ps.rcPaint.right, ps.rcPaint.bottom);
 
+                unsigned long gdi_before = gdi::created();
+                unsigned drawn = 0;
                 RECT rc;
                 GetClientRect(hwnd, &rc);
                 int w = rc.right - rc.left;
                 int h = rc.bottom - rc.top;
-                if (w > 0 && h > 0) {
-                    HDC memDC = CreateCompatibleDC(hdc);
-                    HBITMAP memBM = CreateCompatibleBitmap(hdc, w, h);
-                    HGDIOBJ oldBM = SelectObject(memDC, memBM);
-
-                    // Fill background
-                    HBRUSH bg = CreateSolidBrush(GetSysColor(COLOR_WINDOW));
-                    FillRect(memDC, &rc, bg);
-                    DeleteObject(bg);
-
-                    // Draw widgets
-                    for (auto &wptr : widgets_) {
-                        if (wptr && wptr->visible) wptr->draw(memDC);
-                        if (wptr) wptr->dirty = false;
+                if (w > 0 && h > 0 && !back_dc_) ensure_back_buffer(w, h); // first paint before any WM_SIZE
+                if (back_dc_ && !IsRectEmpty(&ps.rcPaint)) {
+                    HDC memDC = back_dc_;
+                    // keep every draw inside the damaged area so undamaged pixels stay untouched
+                    SelectClipRgn(memDC, damage_rgn_);
+
+                    // Fill background (palette brushes are cached, nothing to free)
+                    FillRect(memDC, &ps.rcPaint, palette().brush(theme().window));
+
+                    // Draw only widgets overlapping the damage
+                    drawn = render(memDC, widgets_);
+#ifdef SOFTGUI_PROFILE
+                    if (overlay_on_) draw_overlay(memDC);
+#endif
+
+                    // Blit only the damaged rectangles
+                    DWORD sz = GetRegionData(damage_rgn_, 0, NULL);
+                    if (sz > damage_data_.size()) damage_data_.resize(sz);
+                    RGNDATA *rd = (RGNDATA*)damage_data_.data();
+                    if (sz && GetRegionData(damage_rgn_, sz, rd) && rd->rdh.nCount <= kMaxBlitRects) {
+                        const RECT *rects = (const RECT*)rd->Buffer;
+                        for (DWORD i = 0; i < rd->rdh.nCount; ++i) {
+                            const RECT &dr = rects[i];
+                            BitBlt(hdc, dr.left, dr.top, dr.right - dr.left, dr.bottom - dr.top, memDC, dr.left, dr.top, SRCCOPY);
+                        }
+                    } else {
+                        const RECT &pr = ps.rcPaint;
+                        BitBlt(hdc, pr.left, pr.top, pr.right - pr.left, pr.bottom - pr.top, memDC, pr.left, pr.top, SRCCOPY);
                     }
 
-                    // Blit to screen
-                    BitBlt(hdc, 0, 0, w, h, memDC, 0, 0, SRCCOPY);
-
-                    SelectObject(memDC, oldBM);
-                    DeleteObject(memBM);
-                    DeleteDC(memDC);
+                    SelectClipRgn(memDC, NULL);
                 }
 
                 EndPaint(hwnd, &ps);
+                stats_.frames++;
+                stats_.widgets_drawn = drawn;
+                stats_.gdi_allocs = gdi::created() - gdi_before;
+                stats_.gdi_handles = GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS);
+#ifdef SOFTGUI_PROFILE
+                {
+                    int64_t end = prof::now_us();
+                    stats_.frame_ms = (end - paint_t0) / 1000.0;
+                    stats_.input_latency_ms = input_t0_us_ ? (end - input_t0_us_) / 1000.0 : 0.0;
+                    input_t0_us_ = 0;
+                    overlay_frame(ps.rcPaint);
+                }
+#endif
                 return 0;
             }
 
             case WM_LBUTTONDOWN: {
                 int x = GET_X_LPARAM(lParam);
                 int y = GET_Y_LPARAM(lParam);
-                // dispatch in reverse order (topmost first)
-                for (auto it = widgets_.rbegin(); it != widgets_.rend(); ++it) {
-                    auto &wptr = *it; // WidgetPtr
-                    if (!wptr->visible) continue;
-                    if (x >= wptr->geom.x && x < wptr->geom.x + wptr->geom.w &&
-                        y >= wptr->geom.y && y < wptr->geom.y + wptr->geom.h) {
-                        // widget-local coords
-                        int lx = x - wptr->geom.x;
-                        int ly = y - wptr->geom.y;
-                        wptr->on_click_internal(lx, ly);
-
-                        // begin capture for dragging (sliders handled while captured)
-                        capture_widget_ = wptr.get();
-                        SetCapture(hwnd);
-
-                        // if the clicked widget is an Entry -> focus management
-                        if (auto e = std::dynamic_pointer_cast<Entry>(wptr)) {
-                            if (focused_entry_ && focused_entry_.get() != e.get()) {
-                                focused_entry_->focused = false;
-                                focused_entry_->mark_dirty();
-                            }
-                            focused_entry_ = e;
-                            e->focused = true;
-                            e->mark_dirty();
-                        } else {
-                            if (focused_entry_) { focused_entry_->focused = false; focused_entry_->mark_dirty(); focused_entry_.reset(); }
-                        }
-
-                        InvalidateRect(hwnd, NULL, FALSE);
-                        break;
+                Widget *w = hit_test(x, y);
+                if (!w) return 0;
+                if (focused_entry_) focused_entry_->value(); // click handlers may read its `text`
+                // widget-local coords
+                w->on_click_internal(x - w->geom.x, y - w->geom.y);
+
+                // begin capture for dragging (sliders handled while captured)
+                capture_widget_ = w;
+                SetCapture(hwnd);
+
+                // if the clicked widget is an Entry -> focus management
+                if (Entry *en = dynamic_cast<Entry*>(w)) {
+                    if (focused_entry_ && focused_entry_ != en) {
+                        focused_entry_->focused = false;
+                        focused_entry_->caret_visible = false;
+                        focused_entry_->repaint();
                     }
+                    focused_entry_ = en;
+                    en->focused = true;
+                    start_caret_blink();
+                    en->repaint();
+                } else if (focused_entry_) {
+                    focused_entry_->focused = false;
+                    focused_entry_->caret_visible = false;
+                    focused_entry_->repaint();
+                    focused_entry_ = nullptr;
+                    stop_caret_blink();
                 }
                 return 0;
             }
 
+            case WM_MOUSEWHEEL: {
+                POINT pt{ GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) }; // screen coordinates
+                ScreenToClient(hwnd, &pt);
+                if (Widget *w = hit_test(pt.x, pt.y)) w->on_wheel(GET_WHEEL_DELTA_WPARAM(wParam));
+                return 0;
+            }
+
             case WM_MOUSEMOVE: {
                 int x = GET_X_LPARAM(lParam);
                 int y = GET_Y_LPARAM(lParam);
                 if (capture_widget_) {
                     Widget* w = capture_widget_;
-                    int lx = x - w->geom.x;
-                    int ly = y - w->geom.y;
-                    // HSlider dragging
-                    if (auto hs = dynamic_cast<HSlider*>(w)) {
-                        int newval = hs->min + lx * (hs->max - hs->min) / std::max(1, w->geom.w - 16);
-                        newval = std::clamp(newval, hs->min, hs->max);
-                        hs->target = (float)newval;
-                        hs->dragging = true;
-                        hs->mark_dirty();
-                        InvalidateRect(hwnd, NULL, FALSE);
-                    }
-                    // VSlider dragging
-                    else if (auto vs = dynamic_cast<VSlider*>(w)) {
-                        int rel = ly;
-                        int newval = vs->min + (w->geom.h - rel - 16) * (vs->max - vs->min) / std::max(1, w->geom.h - 16);
-                        newval = std::clamp(newval, vs->min, vs->max);
-                        vs->target = (float)newval;
-                        vs->dragging = true;
-                        vs->mark_dirty();
-                        InvalidateRect(hwnd, NULL, FALSE);
-                    }
-                    // ComboBox: if expanded and captured, map to option selection quickly
-                    else if (auto cb = dynamic_cast<ComboBox*>(w)) {
-                        if (cb->expanded) {
-                            int idx = (y - w->geom.y - w->geom.h) / cb->option_height;
-                            if (idx >= 0 && idx < (int)cb->options.size()) {
-                                cb->selected = idx; // visual hover
-                                cb->mark_dirty();
-                                InvalidateRect(hwnd, NULL, FALSE);
-                            }
-                        }
-                    }
+                    w->on_drag(x - w->geom.x, y - w->geom.y);
                 }
                 return 0;
             }
@@ -978,36 +2008,10 @@ private:
                 // release capture and end dragging
                 if (capture_widget_) {
                     Widget* w = capture_widget_;
-                    if (auto hs = dynamic_cast<HSlider*>(w)) {
-                        hs->dragging = false;
-                        hs->fvalue = hs->target;
-                        int newv = (int)std::lround(hs->fvalue);
-                        if (newv != hs->value) {
-                            hs->value = newv;
-                            if (hs->on_change) hs->on_change(hs);
-                        }
-                    } else if (auto vs = dynamic_cast<VSlider*>(w)) {
-                        vs->dragging = false;
-                        vs->fvalue = vs->target;
-                        int newv = (int)std::lround(vs->fvalue);
-                        if (newv != vs->value) {
-                            vs->value = newv;
-                            if (vs->on_change) vs->on_change(vs);
-                        }
-                    } else if (auto cb = dynamic_cast<ComboBox*>(w)) {
-                        // ComboBox commit selection on mouse up (if expanded)
-                        if (cb->expanded) {
-                            int idx = (GET_Y_LPARAM(lParam) - w->geom.y - w->geom.h) / cb->option_height;
-                            if (idx >= 0 && idx < (int)cb->options.size()) {
-                                cb->selected = idx;
-                                if (cb->on_change) cb->on_change(cb);
-                            }
-                            cb->expanded = false;
-                        }
-                    }
+                    w->on_release(GET_X_LPARAM(lParam) - w->geom.x, GET_Y_LPARAM(lParam) - w->geom.y);
+                    w->mark_dirty();
                     ReleaseCapture();
                     capture_widget_ = nullptr;
-                    InvalidateRect(hwnd, NULL, FALSE);
                 }
                 return 0;
             }
@@ -1016,7 +2020,14 @@ private:
                 if (wParam == kRefreshTimerId) {
                     // animate sliders and other widgets
                     tick_animate();
+                } else if (wParam == kCaretTimerId) {
+                    tick_caret();
+                }
+#ifdef SOFTGUI_PROFILE
+                else if (wParam == kOverlayTimerId) {
+                    tick_overlay();
                 }
+#endif
                 return 0;
             }
 
@@ -1024,7 +2035,7 @@ private:
                 if (focused_entry_) {
                     char ch = (char)wParam;
                     focused_entry_->on_key_internal(ch);
-                    InvalidateRect(hwnd, NULL, FALSE);
+                    if (focused_entry_->focused) start_caret_blink(); // keep the caret solid while typing
                 }
                 return 0;
             }
@@ -1034,26 +2045,42 @@ private:
                     int vk = (int)wParam;
                     if (vk == VK_LEFT) {
                         if (focused_entry_->caret > 0) focused_entry_->caret--;
-                        focused_entry_->mark_dirty();
-                        InvalidateRect(hwnd, NULL, FALSE);
+                        focused_entry_->repaint();
                     } else if (vk == VK_RIGHT) {
-                        if (focused_entry_->caret < focused_entry_->text.size()) focused_entry_->caret++;
-                        focused_entry_->mark_dirty();
-                        InvalidateRect(hwnd, NULL, FALSE);
+                        if (focused_entry_->caret < focused_entry_->length()) focused_entry_->caret++;
+                        focused_entry_->repaint();
                     }
                 }
                 return 0;
             }
 
+            case WM_DPICHANGED: {
+                // fonts are keyed by DPI; drop them so every widget re-creates at the new scale
+                font_cache().clear();
+                const RECT *suggested = (const RECT*)lParam;
+                SetWindowPos(hwnd, NULL, suggested->left, suggested->top,
+                             suggested->right - suggested->left, suggested->bottom - suggested->top,
+                             SWP_NOZORDER | SWP_NOACTIVATE);
+                InvalidateRect(hwnd, NULL, FALSE);
+                return 0;
+            }
+
             case WM_SIZE:
                 width_ = LOWORD(lParam);
                 height_ = HIWORD(lParam);
+                ensure_back_buffer(width_, height_);
+                hit_stale_ = true; // grid dimensions follow the client area
                 recompute_layout();
                 InvalidateRect(hwnd, NULL, FALSE);
                 return 0;
 
+            case WM_SOFTGUI_POST:
+                run_posted();
+                return 0;
+
             case WM_DESTROY:
-                KillTimer(hwnd_, kRefreshTimerId);
+                stop_timers();
+                release_back_buffer();
                 PostQuitMessage(0);
                 return 0;
         }
@@ -1061,6 +2088,25 @@ private:
     }
 };
 
+// ---------- Out-of-line Widget members (need the complete Window) ----------
+inline void Widget::mark_dirty() {
+    dirty = true;
+    Widget* top = this;
+    while (top->parent) { top = top->parent; top->dirty = true; }
+    if (!top->host) return;
+    // repaint where the widget was and where it is now (covers moves, resizes and collapsing popups)
+    top->host->damage(painted);
+    top->host->damage(bounds());
+    top->host->reindex(this);
+    if (is_animating()) top->host->schedule_animation(this);
+}
+
+inline void Frame::add_child(WidgetPtr w) {
+    w->parent = this;
+    children.push_back(w);
+    if (Window *win = host_window()) win->invalidate_hit_grid();
+}
+
 } // namespace SoftGUI
 
 #endif // SOFTGUI_WIN_HPP
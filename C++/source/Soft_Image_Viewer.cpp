@@ -1,6 +1,9 @@
 #include <windows.h>
 #include <windowsx.h>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <shlwapi.h>
 #include "softgui_win.hpp"
 #include "img_rnd.hpp"
 
@@ -13,11 +16,61 @@ struct ViewerState {
     int offsetX = 0, offsetY = 0;
     bool dragging = false;
     POINT lastMouse = {0, 0};
+    // folder browsing
+    std::vector<std::wstring> folder; // image files next to the opened one, natural order
+    int index = -1;
+    PrefetchCache prefetch{512u * 1024 * 1024, 2};
+    unsigned waitToken = 0;   // nonzero while ShowImage waits on a prefetch worker's decode
+    unsigned lastToken = 0;
+    // persistent back buffer, always holding what is on screen; grown on demand, never shrunk
+    HDC backDC = nullptr;
+    HBITMAP backBm = nullptr;
+    HGDIOBJ backOld = nullptr;
+    int backW = 0, backH = 0;
+    HRGN damage = nullptr; // update region of the paint in progress
 } g_viewer;
 
+const int kPrefetchAhead = 3; // images decoded on each side of the current one
+// posted by a prefetch worker: wParam = the ShowImage wait token, lParam = decode ok
+const UINT WM_VIEWER_PREFETCHED = WM_APP + 0x121;
+
 // Forward declarations
 void LoadImageFile(HWND hwnd);
+void ShowImage(HWND hwnd, int index);
+void OnImageShown(HWND hwnd, bool ok);
 void DrawImageView(HDC hdc, RECT rc);
+void PanView(HWND hwnd, int dx, int dy);
+
+// Returns true when the buffer was (re)created and so holds nothing yet.
+bool EnsureBackBuffer(HWND hwnd, int w, int h) {
+    if (g_viewer.backDC && w <= g_viewer.backW && h <= g_viewer.backH) return false;
+    if (w <= 0 || h <= 0) return false;
+    w = std::max(w, g_viewer.backW);
+    h = std::max(h, g_viewer.backH);
+    HDC wdc = GetDC(hwnd);
+    if (g_viewer.backDC) {
+        SelectObject(g_viewer.backDC, g_viewer.backOld);
+        DeleteObject(g_viewer.backBm);
+    } else {
+        g_viewer.backDC = CreateCompatibleDC(wdc);
+    }
+    g_viewer.backBm = CreateCompatibleBitmap(wdc, w, h);
+    ReleaseDC(hwnd, wdc);
+    g_viewer.backOld = SelectObject(g_viewer.backDC, g_viewer.backBm);
+    g_viewer.backW = w; g_viewer.backH = h;
+    return true;
+}
+
+void ReleaseBackBuffer() {
+    if (g_viewer.backDC) {
+        SelectObject(g_viewer.backDC, g_viewer.backOld);
+        DeleteObject(g_viewer.backBm);
+        DeleteDC(g_viewer.backDC);
+        g_viewer.backDC = nullptr; g_viewer.backBm = nullptr; g_viewer.backOld = nullptr;
+        g_viewer.backW = g_viewer.backH = 0;
+    }
+    if (g_viewer.damage) { DeleteObject(g_viewer.damage); g_viewer.damage = nullptr; }
+}
 
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     switch (msg) {
@@ -25,12 +78,37 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             LoadImageFile(hwnd);
             return 0;
 
+        case WM_ERASEBKGND:
+            return 1; // every pixel comes from the back buffer
+
+        case WM_SIZE:
+            // the image is centred, so a new size moves everything
+            EnsureBackBuffer(hwnd, LOWORD(lParam), HIWORD(lParam));
+            InvalidateRect(hwnd, nullptr, FALSE);
+            return 0;
+
         case WM_PAINT: {
+            // grab the damage region before BeginPaint validates it
+            if (!g_viewer.damage) g_viewer.damage = CreateRectRgn(0, 0, 0, 0);
+            int rgnType = GetUpdateRgn(hwnd, g_viewer.damage, FALSE);
             PAINTSTRUCT ps;
             HDC hdc = BeginPaint(hwnd, &ps);
             RECT rc;
             GetClientRect(hwnd, &rc);
-            DrawImageView(hdc, rc);
+            bool fresh = EnsureBackBuffer(hwnd, rc.right, rc.bottom); // first paint before any WM_SIZE
+            if (g_viewer.backDC && !IsRectEmpty(&ps.rcPaint)) {
+                if (fresh)
+                    SetRectRgn(g_viewer.damage, 0, 0, rc.right, rc.bottom); // later pans scroll all of it
+                else if (rgnType == NULLREGION || rgnType == ERROR)
+                    SetRectRgn(g_viewer.damage, ps.rcPaint.left, ps.rcPaint.top, ps.rcPaint.right, ps.rcPaint.bottom);
+                // render only the damaged pixels; the renderer clips its work to the clip box
+                SelectClipRgn(g_viewer.backDC, g_viewer.damage);
+                DrawImageView(g_viewer.backDC, rc);
+                SelectClipRgn(g_viewer.backDC, nullptr);
+                // hdc is already clipped to the update region
+                BitBlt(hdc, ps.rcPaint.left, ps.rcPaint.top, ps.rcPaint.right - ps.rcPaint.left,
+                       ps.rcPaint.bottom - ps.rcPaint.top, g_viewer.backDC, ps.rcPaint.left, ps.rcPaint.top, SRCCOPY);
+            }
             EndPaint(hwnd, &ps);
             return 0;
         }
@@ -39,7 +117,8 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             int delta = GET_WHEEL_DELTA_WPARAM(wParam);
             float factor = (delta > 0) ? 1.1f : 0.9f;
             g_viewer.zoom *= factor;
-            InvalidateRect(hwnd, nullptr, TRUE);
+            g_viewer.img.NotifyInteraction(hwnd);
+            InvalidateRect(hwnd, nullptr, FALSE);
             return 0;
         }
 
@@ -54,11 +133,13 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             if (g_viewer.dragging) {
                 int x = GET_X_LPARAM(lParam);
                 int y = GET_Y_LPARAM(lParam);
-                g_viewer.offsetX += (x - g_viewer.lastMouse.x);
-                g_viewer.offsetY += (y - g_viewer.lastMouse.y);
+                int dx = x - g_viewer.lastMouse.x, dy = y - g_viewer.lastMouse.y;
+                g_viewer.offsetX += dx;
+                g_viewer.offsetY += dy;
                 g_viewer.lastMouse.x = x;
                 g_viewer.lastMouse.y = y;
-                InvalidateRect(hwnd, nullptr, TRUE);
+                g_viewer.img.NotifyInteraction(hwnd);
+                PanView(hwnd, dx, dy);
             }
             return 0;
 
@@ -67,12 +148,40 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             ReleaseCapture();
             return 0;
 
+        case WM_IMGRND_ASYNC:
+            // preview or finished decode from LoadAsync
+            if (g_viewer.img.HandleAsyncMessage(wParam, lParam)) InvalidateRect(hwnd, nullptr, FALSE);
+            return 0;
+
+        case WM_VIEWER_PREFETCHED: {
+            // the read-ahead decode ShowImage attached to has finished; ignore it if we moved on
+            if (!g_viewer.waitToken || (unsigned)wParam != g_viewer.waitToken) return 0;
+            g_viewer.waitToken = 0;
+            const std::wstring& file = g_viewer.folder[g_viewer.index];
+            std::shared_ptr<DecodedImage> d = lParam ? g_viewer.prefetch.Get(file) : nullptr;
+            if (d || !lParam) {
+                g_viewer.img.SetImage(d, file);
+                OnImageShown(hwnd, d != nullptr);
+            } else {
+                // decoded but already evicted again: decode it ourselves
+                g_viewer.img.LoadAsync(hwnd, file, [hwnd, file](bool ok) {
+                    if (ok) g_viewer.prefetch.Put(file, g_viewer.img.GetDecoded());
+                    OnImageShown(hwnd, ok);
+                });
+            }
+            InvalidateRect(hwnd, nullptr, FALSE);
+            return 0;
+        }
+
         case WM_KEYDOWN:
             if (wParam == 'O') LoadImageFile(hwnd);
+            else if (wParam == VK_RIGHT || wParam == VK_NEXT || wParam == VK_SPACE) ShowImage(hwnd, g_viewer.index + 1);
+            else if (wParam == VK_LEFT || wParam == VK_PRIOR || wParam == VK_BACK) ShowImage(hwnd, g_viewer.index - 1);
             else if (wParam == VK_ESCAPE) PostQuitMessage(0);
             return 0;
 
         case WM_DESTROY:
+            ReleaseBackBuffer();
             PostQuitMessage(0);
             return 0;
     }
@@ -89,18 +198,120 @@ void LoadImageFile(HWND hwnd) {
     ofn.lpstrFilter = L"Image Files\0*.jpg;*.jpeg;*.png;*.bmp;*.gif;*.tif\0All Files\0*.*\0";
     ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
     if (GetOpenFileNameW(&ofn)) {
-        g_viewer.img.Load(path);
-        g_viewer.zoom = 1.0f;
-        g_viewer.offsetX = g_viewer.offsetY = 0;
-        InvalidateRect(hwnd, nullptr, TRUE);
+        // list the folder so left/right can browse it
+        std::wstring file = path;
+        size_t slash = file.find_last_of(L"\\/");
+        std::wstring dir = slash == std::wstring::npos ? L"" : file.substr(0, slash + 1);
+        g_viewer.folder.clear();
+        WIN32_FIND_DATAW fd;
+        HANDLE h = FindFirstFileW((dir + L"*").c_str(), &fd);
+        if (h != INVALID_HANDLE_VALUE) {
+            static const wchar_t* exts[] = { L".jpg", L".jpeg", L".png", L".bmp", L".gif", L".tif", L".tiff" };
+            do {
+                if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+                const wchar_t* ext = PathFindExtensionW(fd.cFileName);
+                for (const wchar_t* e : exts)
+                    if (_wcsicmp(ext, e) == 0) { g_viewer.folder.push_back(dir + fd.cFileName); break; }
+            } while (FindNextFileW(h, &fd));
+            FindClose(h);
+        }
+        std::sort(g_viewer.folder.begin(), g_viewer.folder.end(),
+                  [](const std::wstring& a, const std::wstring& b) { return StrCmpLogicalW(a.c_str(), b.c_str()) < 0; });
+        auto it = std::find_if(g_viewer.folder.begin(), g_viewer.folder.end(),
+                               [&](const std::wstring& f) { return _wcsicmp(f.c_str(), path) == 0; });
+        if (it == g_viewer.folder.end()) it = g_viewer.folder.insert(g_viewer.folder.end(), file);
+        g_viewer.prefetch.Clear();
+        g_viewer.index = -1;
+        ShowImage(hwnd, (int)(it - g_viewer.folder.begin()));
+    }
+}
+
+void UpdateTitle(HWND hwnd, bool ok) {
+    std::wstring title = L"SoftGUI Image Viewer";
+    if (g_viewer.img.IsLoading() || g_viewer.waitToken) title += L" - loading...";
+    else if (!ok) title += L" - could not open image";
+    else title += L" - " + g_viewer.img.GetPath();
+    if (!g_viewer.folder.empty()) {
+        PrefetchCache::Stats s = g_viewer.prefetch.GetStats();
+        title += L"  (" + std::to_wstring(g_viewer.index + 1) + L"/" + std::to_wstring(g_viewer.folder.size()) +
+                 L", cache " + std::to_wstring(s.hits) + L" hits / " + std::to_wstring(s.joined) + L" joined / " +
+                 std::to_wstring(s.misses) + L" misses, " +
+                 std::to_wstring(s.bytes >> 20) + L" MB)";
+    }
+    SetWindowTextW(hwnd, title.c_str());
+}
+
+void OnImageShown(HWND hwnd, bool ok) {
+    // tile very large scans/panoramas instead of caching one full resampled copy
+    g_viewer.img.EnablePyramid((long long)g_viewer.img.GetWidth() * g_viewer.img.GetHeight() > 32000000LL);
+    UpdateTitle(hwnd, ok);
+}
+
+void ShowImage(HWND hwnd, int index) {
+    if (index < 0 || index >= (int)g_viewer.folder.size() || index == g_viewer.index) return;
+    g_viewer.index = index;
+    const std::wstring& file = g_viewer.folder[index];
+
+    g_viewer.waitToken = 0;
+    unsigned token = ++g_viewer.lastToken;
+    if (!token) token = ++g_viewer.lastToken; // 0 means "not waiting"
+    bool waiting = false;
+    std::shared_ptr<DecodedImage> d = g_viewer.prefetch.GetOrWait(file, [hwnd, token](const std::shared_ptr<DecodedImage>& r) {
+        PostMessage(hwnd, WM_VIEWER_PREFETCHED, (WPARAM)token, r != nullptr);
+    }, waiting);
+    if (d) {
+        g_viewer.img.SetImage(d, file);
+        OnImageShown(hwnd, true);
+    } else if (waiting) {
+        // a read-ahead worker is already decoding this file (quick Next presses): wait for it
+        // instead of starting a second decode; the old picture stays up until then
+        g_viewer.img.CancelLoad();
+        g_viewer.waitToken = token;
+        UpdateTitle(hwnd, true);
+    } else {
+        // decode off the UI thread; switching again before this finishes cancels it
+        g_viewer.img.LoadAsync(hwnd, file, [hwnd, file](bool ok) {
+            if (ok) g_viewer.prefetch.Put(file, g_viewer.img.GetDecoded());
+            OnImageShown(hwnd, ok);
+        });
+        UpdateTitle(hwnd, true);
+    }
+
+    // read ahead around the new position, nearest first, forward before backward
+    std::vector<std::wstring> ahead;
+    for (int k = 1; k <= kPrefetchAhead; ++k) {
+        if (index + k < (int)g_viewer.folder.size()) ahead.push_back(g_viewer.folder[index + k]);
+        if (index - k >= 0) ahead.push_back(g_viewer.folder[index - k]);
+    }
+    g_viewer.prefetch.Prefetch(ahead, file);
+
+    g_viewer.zoom = 1.0f;
+    g_viewer.offsetX = g_viewer.offsetY = 0;
+    InvalidateRect(hwnd, nullptr, FALSE);
+}
+
+// Moves the picture by (dx, dy): the pixels already on screen (and in the back buffer) are
+// shifted in place, and only the strips uncovered by the move get rendered on the next paint.
+void PanView(HWND hwnd, int dx, int dy) {
+    if (!dx && !dy) return;
+    RECT rc;
+    GetClientRect(hwnd, &rc);
+    if (!g_viewer.backDC || abs(dx) >= rc.right || abs(dy) >= rc.bottom) {
+        InvalidateRect(hwnd, nullptr, FALSE);
+        return;
     }
+    // the back buffer must match the screen before both are shifted together
+    if (GetUpdateRect(hwnd, nullptr, FALSE)) UpdateWindow(hwnd);
+    ScrollDC(g_viewer.backDC, dx, dy, &rc, &rc, nullptr, nullptr);
+    ScrollWindowEx(hwnd, dx, dy, &rc, &rc, nullptr, nullptr, SW_INVALIDATE);
 }
 
 void DrawImageView(HDC hdc, RECT rc) {
     FillRect(hdc, &rc, (HBRUSH)(COLOR_WINDOW + 1));
 
     if (!g_viewer.img.IsValid()) {
-        DrawTextW(hdc, L"Press 'O' to open an image.", -1, &rc, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
+        const wchar_t* msg = g_viewer.img.IsLoading() ? L"Loading..." : L"Press 'O' to open an image.";
+        DrawTextW(hdc, msg, -1, &rc, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
         return;
     }
 
@@ -114,7 +325,8 @@ void DrawImageView(HDC hdc, RECT rc) {
     int x = (winW - scaledW) / 2 + g_viewer.offsetX;
     int y = (winH - scaledH) / 2 + g_viewer.offsetY;
 
-    g_viewer.img.Draw(hdc, x, y, scaledW, scaledH, false);
+    // nearest-neighbour while zooming/dragging; the renderer repaints in HQ once idle
+    g_viewer.img.Draw(hdc, x, y, scaledW, scaledH, false, RenderQuality::Auto);
 }
 
 // Correct entry point for GUI subsystem
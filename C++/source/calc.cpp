@@ -1,4 +1,5 @@
 #include "easycpp.hpp"
+#include "calc_expr.hpp"
 
 int main() {
     // Create main window
@@ -15,6 +16,13 @@ int main() {
     char op = 0;
     bool newInput = false;
 
+    // each operator is a compiled "a op b", evaluated with a = lastValue and b = the new input
+    map<char, CalcExpr::Program> programs;
+    for (char o : string("+-*/")) {
+        string err;
+        CalcExpr::compile(string("a") + o + "b", programs[o], err);
+    }
+
     auto update_display = [&]() {
         display->text = current.empty() ? "0" : current;
         display->mark_dirty();
@@ -38,18 +46,10 @@ int main() {
 
     auto calculate = [&]() {
         if (current.empty() || op == 0) return;
-        double val2 = stod(current);
-        double result = lastValue;
-
-        switch (op) {
-            case '+': result += val2; break;
-            case '-': result -= val2; break;
-            case '*': result *= val2; break;
-            case '/': 
-                if (val2 != 0) result /= val2; 
-                else { display->text = "Error"; display->mark_dirty(); return; }
-                break;
-        }
+        double vars[2] = { lastValue, stod(current) };
+        bool ok = false;
+        double result = CalcExpr::eval(programs[op], vars, ok);
+        if (!ok) { display->text = "Error"; display->mark_dirty(); return; }
 
         current = to_string(result);
         // trim trailing .000000
@@ -1,4 +1,5 @@
 #include "softgui_win.hpp"
+#include "calc_expr.hpp"
 #include <string>
 #include <sstream>
 #include <cmath>
@@ -18,6 +19,14 @@ int main() {
     double stored_value = 0.0;
     bool new_input = true;
 
+    // compiled "a op b" per operator; a is the running value, b the number just entered
+    CalcExpr::Program programs[4];
+    const char op_chars[] = "+-*/";
+    for (int i = 0; i < 4; ++i) {
+        std::string err;
+        CalcExpr::compile(std::string("a") + op_chars[i] + "b", programs[i], err);
+    }
+
     auto make_button = [&](const std::string &txt, int x, int y, int w = 60, int h = 40) {
         auto b = win.make_button(txt);
         b->geom.x = x; b->geom.y = y; b->geom.w = w; b->geom.h = h;
@@ -38,11 +47,9 @@ int main() {
 
     auto press_op = [&](char op) {
         double val = current_input.empty() ? 0.0 : std::stod(current_input);
-        if (last_op) {
-            if (last_op == '+') stored_value += val;
-            else if (last_op == '-') stored_value -= val;
-            else if (last_op == '*') stored_value *= val;
-            else if (last_op == '/') stored_value /= val;
+        if (const char *p = last_op ? strchr(op_chars, last_op) : nullptr) {
+            double vars[2] = { stored_value, val };
+            stored_value = CalcExpr::eval(programs[p - op_chars], vars);
         } else {
             stored_value = val;
         }
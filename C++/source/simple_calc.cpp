@@ -1,109 +1,16 @@
 // simple_calc.cpp — Simple calculator using SoftGUI
 #include "softgui_win.hpp"
+#include "calc_expr.hpp"
 #include <string>
 #include <vector>
-#include <stack>
 #include <sstream>
 #include <cmath>
 #include <iomanip>
-#include <cctype>
 
 using namespace SoftGUI;
 
-// ---- simple expression evaluator (shunting-yard -> RPN -> eval) ----
-static bool is_op_char(char c) { return c=='+'||c=='-'||c=='*'||c=='/'||c=='^'; }
-static int prec(char op) {
-    if (op=='+'||op=='-') return 1;
-    if (op=='*'||op=='/') return 2;
-    if (op=='^') return 3;
-    return 0;
-}
-
-double eval_expression(const std::string &expr, bool &ok, std::string &err) {
-    ok = false; err.clear();
-    // tokenize to RPN
-    std::vector<std::string> output;
-    std::stack<char> ops;
-    size_t i = 0;
-    auto push_num = [&](const std::string &num){ output.push_back(num); };
-    while (i < expr.size()) {
-        char c = expr[i];
-        if (isspace((unsigned char)c)) { ++i; continue; }
-        if ( (c>='0' && c<='9') || c=='.' ) {
-            std::string num;
-            while (i < expr.size() && ( (expr[i]>='0' && expr[i]<='9') || expr[i]=='.' || expr[i]=='e' || expr[i]=='E' ||
-                    ((expr[i]=='+'||expr[i]=='-') && !num.empty() && (num.back()=='e' || num.back()=='E')) ) ) {
-                num.push_back(expr[i++]);
-            }
-            push_num(num);
-            continue;
-        } else if (is_op_char(c)) {
-            // unary minus handling: if '-' and it's start or after '(' or another operator -> treat as unary by pushing 0
-            if (c=='-' && (output.empty() && ops.empty() && (i==0 || expr[i-1]=='(') )) {
-                // unary at start: push 0 then minus
-                push_num("0");
-            } else if (c=='-' && (i==0 || expr[i-1]=='(' || is_op_char(expr[i-1]))) {
-                push_num("0");
-            }
-            while (!ops.empty() && is_op_char(ops.top()) &&
-                ( (prec(ops.top()) > prec(c)) || (prec(ops.top()) == prec(c) && c != '^') ) ) {
-                output.push_back(std::string(1, ops.top())); ops.pop();
-            }
-            ops.push(c); ++i;
-        } else if (c == '(') {
-            ops.push(c); ++i;
-        } else if (c == ')') {
-            bool found = false;
-            while (!ops.empty()) {
-                char t = ops.top(); ops.pop();
-                if (t == '(') { found = true; break; }
-                output.push_back(std::string(1,t));
-            }
-            if (!found) { err = "Mismatched parenthesis"; return 0.0; }
-            ++i;
-        } else {
-            err = std::string("Unexpected char: ") + c;
-            return 0.0;
-        }
-    }
-    while (!ops.empty()) {
-        char t = ops.top(); ops.pop();
-        if (t == '(' || t == ')') { err = "Mismatched parenthesis"; return 0.0; }
-        output.push_back(std::string(1,t));
-    }
-
-    // evaluate RPN
-    std::stack<double> st;
-    for (auto &tk : output) {
-        if (tk.empty()) continue;
-        if (tk.size() == 1 && is_op_char(tk[0])) {
-            if (st.size() < 2) { err = "Syntax error"; return 0.0; }
-            double b = st.top(); st.pop();
-            double a = st.top(); st.pop();
-            double r = 0;
-            switch (tk[0]) {
-                case '+': r = a + b; break;
-                case '-': r = a - b; break;
-                case '*': r = a * b; break;
-                case '/': if (b == 0.0) { err = "Division by zero"; return 0.0; } r = a / b; break;
-                case '^': r = std::pow(a, b); break;
-                default: err = "Unknown op"; return 0.0;
-            }
-            st.push(r);
-        } else {
-            // number
-            try {
-                size_t pos = 0;
-                double v = std::stod(tk, &pos);
-                if (pos == 0) { err = std::string("Bad number: ") + tk; return 0.0; }
-                st.push(v);
-            } catch (...) { err = std::string("Bad number: ") + tk; return 0.0; }
-        }
-    }
-    if (st.size() != 1) { err = "Syntax error"; return 0.0; }
-    ok = true;
-    return st.top();
-}
+// expressions are compiled and evaluated by calc_expr.hpp
+using CalcExpr::eval_expression;
 
 // ---- UI ----
 int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
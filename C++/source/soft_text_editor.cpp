@@ -1,13 +1,22 @@
 // soft_text_editor.cpp
 // Simple Windows text editor (single-file) using the Win32 API.
 // A lightweight "soft GUI"-style text editor: New / Open / Save / Save As / Exit
-// Compile with: g++ soft_text_editor.cpp -o soft_text_editor.exe -mwindows -lcomdlg32 -lgdi32
+// Files over kLargeFileThreshold open read-only in a memory-mapped, custom-drawn view.
+// Compile with: g++ soft_text_editor.cpp -o soft_text_editor.exe -I../lib -mwindows -lcomdlg32 -lgdi32
 
 #include <windows.h>
 #include <commdlg.h>
 #include <stdio.h>
 #include <string>
 #include <fstream>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <cstring>
+#include "softgui_text.hpp"
 
 // Menu command IDs
 #define IDM_FILE_NEW   1001
@@ -15,11 +24,278 @@
 #define IDM_FILE_SAVE  1003
 #define IDM_FILE_SAVEAS 1004
 #define IDM_FILE_EXIT  1005
+#define IDM_FILE_AUTOSAVE 1006
+#define IDM_EDIT_FIND      1101
+#define IDM_EDIT_FINDNEXT  1102
+#define IDM_EDIT_REPLACE   1103
+
+// Posted by the line indexer to the large-file view
+#define WM_APP_INDEX_PROGRESS (WM_APP + 1)
+// Posted by the save worker to the main window; wParam is the job serial
+#define WM_APP_SAVE_PROGRESS (WM_APP + 2)
+#define WM_APP_SAVE_DONE     (WM_APP + 3)
+// Posted by the search worker; wParam is the job serial
+#define WM_APP_SEARCH_PROGRESS (WM_APP + 4)
+#define WM_APP_SEARCH_DONE     (WM_APP + 5)
+
+#define AUTOSAVE_TIMER_ID 1
+const UINT kAutosaveIntervalMs = 60 * 1000;
+
+const unsigned long long kLargeFileThreshold = 16ull * 1024 * 1024;
 
 HWND hEdit = NULL;
 HWND hMain = NULL;
+HWND hView = NULL;   // large-file view, shown instead of hEdit in large mode
 std::string currentFile;
 bool isModified = false;
+bool largeMode = false;
+bool autosave = false;
+unsigned editCount = 0;  // bumped on every change; tells a finished save whether it is still current
+
+// ---- Large-file mode: read-only mapped file, background line index, custom view ----
+
+struct MappedFile
+{
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+    const char *data = nullptr;
+    unsigned long long size = 0;
+
+    bool Open(const std::string &filename)
+    {
+        Close();
+        file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER li;
+        if (!GetFileSizeEx(file, &li) || (unsigned long long)li.QuadPart > (SIZE_T)-1) { Close(); return false; }
+        size = (unsigned long long)li.QuadPart;
+        if (size == 0) return true; // empty files cannot be mapped
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data) { Close(); return false; }
+        return true;
+    }
+    void Close()
+    {
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        data = nullptr;
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+        size = 0;
+    }
+    ~MappedFile() { Close(); }
+};
+
+// Start offset of every line, filled in by a background thread. Offsets live in fixed-size
+// blocks that never move, so the UI thread may read any line below Count() while it runs.
+class LineIndex
+{
+public:
+    static const size_t kBlock = 65536;
+
+    ~LineIndex() { Stop(); }
+
+    void Start(const char *data, unsigned long long size, HWND notify)
+    {
+        Stop();
+        blocks.clear();
+        blocks.resize((size_t)(size / kBlock) + 2); // a file of n bytes has at most n + 1 lines
+        fileSize = size;
+        count = 0;
+        done = false;
+        cancel = false;
+        worker = std::thread([=] { Run(data, size, notify); });
+    }
+    void Stop()
+    {
+        cancel = true;
+        if (worker.joinable()) worker.join();
+    }
+
+    size_t Count() const { return count.load(std::memory_order_acquire); }
+    bool Done() const { return done.load(std::memory_order_acquire); }
+    // lines that can be drawn: the last indexed one is open-ended until indexing finishes
+    size_t Lines() const { size_t c = Count(); return Done() ? c : (c ? c - 1 : 0); }
+    unsigned long long LineStart(size_t line) const { return blocks[line / kBlock][line % kBlock]; }
+    unsigned long long LineEnd(size_t line) const { return line + 1 < Count() ? LineStart(line + 1) : fileSize; }
+    // line containing byte `off`, among the lines indexed so far
+    size_t LineOf(unsigned long long off) const
+    {
+        size_t lo = 0, hi = Count();
+        while (hi - lo > 1) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (LineStart(mid) <= off) lo = mid; else hi = mid;
+        }
+        return lo;
+    }
+
+private:
+    std::vector<std::unique_ptr<unsigned long long[]>> blocks;
+    unsigned long long fileSize = 0;
+    std::atomic<size_t> count{0};
+    std::atomic<bool> done{false}, cancel{false};
+    std::thread worker;
+
+    void Run(const char *data, unsigned long long size, HWND notify)
+    {
+        size_t n = 0;
+        auto append = [&](unsigned long long off) {
+            std::unique_ptr<unsigned long long[]> &b = blocks[n / kBlock];
+            if (!b) b.reset(new unsigned long long[kBlock]);
+            b[n % kBlock] = off;
+            ++n;
+        };
+        append(0);
+        const char *p = data, *end = data + size;
+        DWORD lastPost = GetTickCount();
+        while (p < end && !cancel) {
+            // 4 MB slices keep cancellation and progress responsive
+            const char *slice = p + (size_t)std::min<unsigned long long>(end - p, 4u << 20);
+            while (const char *nl = (const char *)memchr(p, '\n', slice - p)) {
+                p = nl + 1;
+                append(p - data);
+            }
+            p = slice;
+            count.store(n, std::memory_order_release);
+            if (GetTickCount() - lastPost >= 100) {
+                PostMessageA(notify, WM_APP_INDEX_PROGRESS, 0, 0);
+                lastPost = GetTickCount();
+            }
+        }
+        count.store(n, std::memory_order_release);
+        done.store(!cancel, std::memory_order_release);
+        PostMessageA(notify, WM_APP_INDEX_PROGRESS, 0, 0);
+    }
+};
+
+MappedFile g_map;
+LineIndex g_lines;
+SoftGUI::TextBuffer g_doc; // large-mode document: a view over g_map
+
+// ---- Background save: snapshot -> temp file -> flush -> atomic rename over the target ----
+
+struct SaveJob
+{
+    unsigned serial = 0;
+    std::string target, temp;
+    SoftGUI::TextBuffer snapshot;
+    unsigned editsAtSnapshot = 0;
+    std::atomic<unsigned long long> written{0};
+    bool ok = false;
+    std::thread worker;
+};
+std::unique_ptr<SaveJob> g_save;
+unsigned g_saveSerial = 0;
+
+// ---- Search: a worker scans a snapshot and streams match offsets back ----
+
+struct SearchJob
+{
+    unsigned serial = 0;
+    std::string needle;
+    bool matchCase = true;
+    SoftGUI::TextBuffer snapshot;
+    std::atomic<bool> cancel{false}, done{false};
+    std::atomic<unsigned long long> scanned{0};
+    std::mutex mu;
+    std::vector<unsigned long long> hits; // ascending, guarded by mu
+    std::thread worker;
+};
+std::unique_ptr<SearchJob> g_search;
+unsigned g_searchSerial = 0;
+unsigned g_replaceSerial = 0; // search a pending Replace All waits on (0 = none)
+
+void RunSearch(SearchJob &job, HWND notify)
+{
+    SoftGUI::TextFinder finder(job.needle, job.matchCase);
+    DWORD lastPost = 0;
+    auto progress = [&](bool force) {
+        if (force || GetTickCount() - lastPost >= 100) {
+            PostMessageA(notify, WM_APP_SEARCH_PROGRESS, job.serial, 0);
+            lastPost = GetTickCount();
+        }
+    };
+    finder.find_all(job.snapshot, 0,
+        [&](size_t pos) {
+            bool first;
+            {
+                std::lock_guard<std::mutex> lk(job.mu);
+                first = job.hits.empty();
+                job.hits.push_back(pos);
+            }
+            job.scanned = pos;
+            progress(first); // the first hit goes out at once
+            return !job.cancel;
+        },
+        [&](size_t pos) {
+            job.scanned = pos;
+            progress(false);
+            return !job.cancel;
+        });
+    job.done = true;
+    PostMessageA(notify, WM_APP_SEARCH_DONE, job.serial, 0);
+}
+
+void CancelSearch()
+{
+    g_replaceSerial = 0; // a Replace All only applies to the scan it was asked for
+    if (!g_search) return;
+    g_search->cancel = true;
+    if (g_search->worker.joinable()) g_search->worker.join();
+    g_search.reset();
+}
+
+void TryShowMatch();
+
+// runs on the worker: stream the snapshot in 1 MB writes, then swap it in
+void RunSave(SaveJob &job, HWND notify)
+{
+    HANDLE h = CreateFileA(job.temp.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    bool ok = h != INVALID_HANDLE_VALUE;
+    DWORD lastPost = GetTickCount();
+    if (ok) {
+        job.snapshot.for_each_chunk([&](std::string_view chunk) {
+            while (ok && !chunk.empty()) {
+                DWORD n = (DWORD)std::min<size_t>(chunk.size(), 1u << 20), done = 0;
+                ok = WriteFile(h, chunk.data(), n, &done, NULL) && done == n;
+                chunk.remove_prefix(n);
+                job.written += n;
+                if (GetTickCount() - lastPost >= 100) {
+                    PostMessageA(notify, WM_APP_SAVE_PROGRESS, job.serial, 0);
+                    lastPost = GetTickCount();
+                }
+            }
+        });
+        ok = FlushFileBuffers(h) && ok;
+        CloseHandle(h);
+    }
+    // the target is replaced only once the new contents are safely on disk; ReplaceFile keeps an
+    // existing target's ACLs, attributes, creation time, streams and hard links, a rename would not
+    if (ok) {
+        if (GetFileAttributesA(job.target.c_str()) != INVALID_FILE_ATTRIBUTES)
+            ok = ReplaceFileA(job.target.c_str(), job.temp.c_str(), NULL, REPLACEFILE_IGNORE_MERGE_ERRORS, NULL, NULL) != 0;
+        else
+            ok = MoveFileExA(job.temp.c_str(), job.target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+    }
+    if (!ok) DeleteFileA(job.temp.c_str());
+    job.ok = ok;
+    PostMessageA(notify, WM_APP_SAVE_DONE, job.serial, 0);
+}
+
+struct LargeViewState
+{
+    size_t top = 0;     // first visible line
+    int leftCol = 0;    // horizontal scroll, in characters
+    int lineH = 16, charW = 8;
+    int wheelAccum = 0; // partial wheel scroll, in lines * WHEEL_DELTA
+    HFONT font = NULL;
+    unsigned long long hlStart = 0, hlLen = 0; // highlighted search match
+} g_view;
+
+const int kViewMaxCols = 4096; // horizontal scroll range
 
 void UpdateTitle()
 {
@@ -28,26 +304,309 @@ void UpdateTitle()
         title += " - ";
         title += currentFile;
     }
+    if (largeMode) {
+        title += " [read-only]";
+        if (!g_lines.Done()) title += " - indexing " + std::to_string(g_lines.Count()) + " lines...";
+        else title += " - " + std::to_string(g_lines.Lines()) + " lines";
+    }
+    if (g_search) {
+        size_t n;
+        {
+            std::lock_guard<std::mutex> lk(g_search->mu);
+            n = g_search->hits.size();
+        }
+        unsigned long long total = g_search->snapshot.size();
+        if (!g_search->done) title += " - searching " + std::to_string(total ? g_search->scanned * 100 / total : 100) + "%";
+        title += " - " + std::to_string(n) + " matches for \"" + g_search->needle + "\"";
+    }
+    if (g_save) {
+        unsigned long long total = g_save->snapshot.size();
+        unsigned long long pct = total ? g_save->written * 100 / total : 100;
+        title += " - saving " + std::to_string(pct) + "%";
+    }
     if (isModified) title = "*" + title;
     SetWindowTextA(hMain, title.c_str());
 }
 
-bool SaveToFile(const std::string &filename)
+int ViewRows()
+{
+    RECT rc;
+    GetClientRect(hView, &rc);
+    return std::max(1, (int)(rc.bottom / g_view.lineH));
+}
+
+void UpdateViewScroll()
 {
+    size_t lines = g_lines.Lines();
+    SCROLLINFO si = { sizeof(si) };
+    si.fMask = SIF_RANGE | SIF_PAGE | SIF_POS;
+    si.nMin = 0;
+    si.nMax = (int)std::min<size_t>(lines ? lines - 1 : 0, 0x7FFFFFFF);
+    si.nPage = ViewRows();
+    si.nPos = (int)g_view.top;
+    SetScrollInfo(hView, SB_VERT, &si, TRUE);
+    RECT rc;
+    GetClientRect(hView, &rc);
+    si.nMax = kViewMaxCols;
+    si.nPage = std::max(1, (int)(rc.right / g_view.charW));
+    si.nPos = g_view.leftCol;
+    SetScrollInfo(hView, SB_HORZ, &si, TRUE);
+}
+
+void ViewScrollTo(long long top, int leftCol)
+{
+    long long maxTop = (long long)g_lines.Lines() - ViewRows();
+    top = std::max(0LL, std::min(top, maxTop));
+    leftCol = std::max(0, std::min(leftCol, kViewMaxCols));
+    if ((size_t)top == g_view.top && leftCol == g_view.leftCol) return;
+    g_view.top = (size_t)top;
+    g_view.leftCol = leftCol;
+    UpdateViewScroll();
+    InvalidateRect(hView, NULL, FALSE);
+}
+
+LRESULT CALLBACK LargeViewProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    switch (msg) {
+    case WM_ERASEBKGND:
+        return 1; // WM_PAINT fills everything
+
+    case WM_PAINT:
+    {
+        PAINTSTRUCT ps;
+        HDC hdc = BeginPaint(hWnd, &ps);
+        RECT rc;
+        GetClientRect(hWnd, &rc);
+        FillRect(hdc, &ps.rcPaint, (HBRUSH)GetStockObject(WHITE_BRUSH));
+        HGDIOBJ oldFont = SelectObject(hdc, g_view.font);
+        SetBkMode(hdc, TRANSPARENT);
+        int cols = rc.right / g_view.charW + 1;
+        size_t lines = g_lines.Lines();
+        int first = ps.rcPaint.top / g_view.lineH, last = ps.rcPaint.bottom / g_view.lineH;
+        for (int row = first; row <= last; ++row) {
+            size_t line = g_view.top + row;
+            if (line >= lines) break;
+            unsigned long long s = g_lines.LineStart(line), e = g_lines.LineEnd(line);
+            while (e > s && (g_map.data[e - 1] == '\n' || g_map.data[e - 1] == '\r')) --e;
+            // only the characters that can reach the screen (tabs may widen them a little)
+            int n = (int)std::min<unsigned long long>(e - s, (unsigned long long)(g_view.leftCol + cols));
+            unsigned long long hs = std::max(s, g_view.hlStart), he = std::min(e, g_view.hlStart + g_view.hlLen);
+            if (g_view.hlLen && hs < he && hs - s < (unsigned long long)n) {
+                int x0 = LOWORD(GetTabbedTextExtentA(hdc, g_map.data + s, (int)(hs - s), 0, NULL));
+                int x1 = LOWORD(GetTabbedTextExtentA(hdc, g_map.data + s, (int)std::min<unsigned long long>(he - s, n), 0, NULL));
+                RECT hr = { x0 - g_view.leftCol * g_view.charW, row * g_view.lineH, x1 - g_view.leftCol * g_view.charW, (row + 1) * g_view.lineH };
+                FillRect(hdc, &hr, GetSysColorBrush(COLOR_HIGHLIGHT));
+            }
+            if (n > 0)
+                TabbedTextOutA(hdc, -g_view.leftCol * g_view.charW, row * g_view.lineH, g_map.data + s, n, 0, NULL, 0);
+        }
+        SelectObject(hdc, oldFont);
+        EndPaint(hWnd, &ps);
+        return 0;
+    }
+
+    case WM_SIZE:
+        UpdateViewScroll();
+        return 0;
+
+    case WM_APP_INDEX_PROGRESS:
+    {
+        // a match beyond the indexed lines is shown once indexing reaches it
+        TryShowMatch();
+        // more lines are drawable now; repaint only if the view was short of lines
+        UpdateViewScroll();
+        if (g_view.top + ViewRows() + 1 >= g_lines.Count()) InvalidateRect(hWnd, NULL, FALSE);
+        UpdateTitle();
+        return 0;
+    }
+
+    case WM_VSCROLL:
+    {
+        SCROLLINFO si = { sizeof(si) };
+        si.fMask = SIF_ALL;
+        GetScrollInfo(hWnd, SB_VERT, &si);
+        long long top = (long long)g_view.top;
+        switch (LOWORD(wParam)) {
+        case SB_LINEUP: top -= 1; break;
+        case SB_LINEDOWN: top += 1; break;
+        case SB_PAGEUP: top -= ViewRows(); break;
+        case SB_PAGEDOWN: top += ViewRows(); break;
+        case SB_TOP: top = 0; break;
+        case SB_BOTTOM: top = (long long)g_lines.Lines(); break;
+        case SB_THUMBTRACK: case SB_THUMBPOSITION: top = si.nTrackPos; break;
+        }
+        ViewScrollTo(top, g_view.leftCol);
+        return 0;
+    }
+
+    case WM_HSCROLL:
+    {
+        SCROLLINFO si = { sizeof(si) };
+        si.fMask = SIF_ALL;
+        GetScrollInfo(hWnd, SB_HORZ, &si);
+        int col = g_view.leftCol;
+        switch (LOWORD(wParam)) {
+        case SB_LINELEFT: col -= 1; break;
+        case SB_LINERIGHT: col += 1; break;
+        case SB_PAGELEFT: col -= (int)si.nPage; break;
+        case SB_PAGERIGHT: col += (int)si.nPage; break;
+        case SB_THUMBTRACK: case SB_THUMBPOSITION: col = si.nTrackPos; break;
+        }
+        ViewScrollTo((long long)g_view.top, col);
+        return 0;
+    }
+
+    case WM_MOUSEWHEEL:
+    {
+        // 3 lines per notch; high-resolution wheels and touchpads send partial notches
+        int d = GET_WHEEL_DELTA_WPARAM(wParam) * 3;
+        if ((d < 0) != (g_view.wheelAccum < 0)) g_view.wheelAccum = 0; // direction changed
+        g_view.wheelAccum += d;
+        int lines = g_view.wheelAccum / WHEEL_DELTA;
+        if (lines) {
+            g_view.wheelAccum -= lines * WHEEL_DELTA;
+            ViewScrollTo((long long)g_view.top - lines, g_view.leftCol);
+        }
+        return 0;
+    }
+
+    case WM_KEYDOWN:
+    {
+        bool ctrl = (GetKeyState(VK_CONTROL) & 0x8000) != 0;
+        long long top = (long long)g_view.top;
+        int col = g_view.leftCol;
+        switch (wParam) {
+        case VK_UP: top -= 1; break;
+        case VK_DOWN: top += 1; break;
+        case VK_PRIOR: top -= ViewRows(); break;
+        case VK_NEXT: top += ViewRows(); break;
+        case VK_HOME: if (ctrl) top = 0; col = 0; break;
+        case VK_END: if (ctrl) top = (long long)g_lines.Lines(); break;
+        case VK_LEFT: col -= 4; break;
+        case VK_RIGHT: col += 4; break;
+        default: return DefWindowProcA(hWnd, msg, wParam, lParam);
+        }
+        ViewScrollTo(top, col);
+        return 0;
+    }
+
+    case WM_LBUTTONDOWN:
+        SetFocus(hWnd);
+        return 0;
+    }
+    return DefWindowProcA(hWnd, msg, wParam, lParam);
+}
+
+// Wait for the running save, if any, and apply its result. Returns false if it failed.
+bool FinishSave()
+{
+    if (!g_save) return true;
+    std::unique_ptr<SaveJob> job = std::move(g_save);
+    if (job->worker.joinable()) job->worker.join();
+    if (job->ok) {
+        currentFile = job->target;
+        if (editCount == job->editsAtSnapshot) isModified = false;
+    } else {
+        MessageBoxA(hMain, ("Failed to save " + job->target).c_str(), "Error", MB_OK | MB_ICONERROR);
+    }
+    UpdateTitle();
+    return job->ok;
+}
+
+void UpdateMenus()
+{
+    // the large-file view is read-only
+    EnableMenuItem(GetMenu(hMain), IDM_EDIT_REPLACE, MF_BYCOMMAND | (largeMode ? MF_GRAYED : MF_ENABLED));
+}
+
+void LeaveLargeMode()
+{
+    if (!largeMode) return;
+    FinishSave(); // a Save As may still be reading the mapping
+    CancelSearch();
+    g_lines.Stop();
+    g_doc.clear();
+    g_map.Close();
+    largeMode = false;
+    g_view.hlLen = 0;
+    ShowWindow(hView, SW_HIDE);
+    ShowWindow(hEdit, SW_SHOW);
+    SetFocus(hEdit);
+    UpdateMenus();
+}
+
+bool EnterLargeMode(const std::string &filename)
+{
+    LeaveLargeMode();
+    CancelSearch();
+    if (!g_map.Open(filename)) return false;
+    g_doc = SoftGUI::TextBuffer::view(std::string_view(g_map.data, (size_t)g_map.size));
+    largeMode = true;
+    SetWindowTextA(hEdit, ""); // release the previous document
+    g_view.top = 0;
+    g_view.leftCol = 0;
+    g_view.hlLen = 0;
+    UpdateMenus();
+    g_lines.Start(g_map.data, g_map.size, hView);
+    ShowWindow(hEdit, SW_HIDE);
+    ShowWindow(hView, SW_SHOW);
+    UpdateViewScroll();
+    InvalidateRect(hView, NULL, FALSE);
+    SetFocus(hView);
+    return true;
+}
+
+// The document as worker threads see it: O(1) in large mode, one copy out of the EDIT
+// control's own buffer otherwise (workers never touch the control).
+SoftGUI::TextBuffer SnapshotDocument()
+{
+    if (largeMode) return g_doc.snapshot();
     int len = GetWindowTextLengthA(hEdit);
+    HLOCAL hText = (HLOCAL)SendMessageA(hEdit, EM_GETHANDLE, 0, 0);
+    const char *text = hText ? (const char *)LocalLock(hText) : NULL;
     std::string buf;
-    buf.resize(len);
-    GetWindowTextA(hEdit, &buf[0], len + 1);
+    if (text) {
+        buf.assign(text, len);
+        LocalUnlock(hText);
+    } else {
+        buf.resize(len);
+        GetWindowTextA(hEdit, &buf[0], len + 1);
+    }
+    return SoftGUI::TextBuffer(std::move(buf));
+}
 
-    std::ofstream ofs(filename, std::ios::binary);
-    if (!ofs) return false;
-    ofs.write(buf.data(), buf.size());
-    ofs.close();
-    return true;
+// Snapshot the document and save it on a worker thread. With wait, block until it is
+// on disk and return the result; otherwise return at once and finish on WM_APP_SAVE_DONE.
+bool SaveToFile(const std::string &filename, bool wait = true)
+{
+    if (!FinishSave() && wait) return false;
+    // the mapped view is read-only: saving in place has nothing to do, Save As copies it
+    if (largeMode && _stricmp(filename.c_str(), currentFile.c_str()) == 0) return true;
+    SoftGUI::TextBuffer snapshot = SnapshotDocument();
+
+    std::unique_ptr<SaveJob> job(new SaveJob());
+    job->serial = ++g_saveSerial;
+    job->target = filename;
+    job->temp = filename + ".~save" + std::to_string(GetCurrentProcessId());
+    job->snapshot = std::move(snapshot);
+    job->editsAtSnapshot = editCount;
+    SaveJob *j = job.get();
+    HWND notify = hMain;
+    job->worker = std::thread([j, notify] { RunSave(*j, notify); });
+    g_save = std::move(job);
+    UpdateTitle();
+    return wait ? FinishSave() : true;
 }
 
 bool LoadFromFile(const std::string &filename)
 {
+    FinishSave(); // do not let a late save rename currentFile under the new document
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &fad)) {
+        unsigned long long size = ((unsigned long long)fad.nFileSizeHigh << 32) | fad.nFileSizeLow;
+        if (size > kLargeFileThreshold) return EnterLargeMode(filename);
+    }
+    LeaveLargeMode();
     std::ifstream ifs(filename, std::ios::binary);
     if (!ifs) return false;
     std::string contents((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
@@ -55,7 +614,7 @@ bool LoadFromFile(const std::string &filename)
     return true;
 }
 
-bool DoFileSaveAs()
+bool DoFileSaveAs(bool wait = true)
 {
     char szFile[260] = {0};
     OPENFILENAMEA ofn = {0};
@@ -66,26 +625,15 @@ bool DoFileSaveAs()
     ofn.lpstrFilter = "Text Files\0*.txt\0All Files\0*.*\0";
     ofn.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
     ofn.lpstrDefExt = "txt";
-    if (GetSaveFileNameA(&ofn)) {
-        if (SaveToFile(ofn.lpstrFile)) {
-            currentFile = ofn.lpstrFile;
-            isModified = false;
-            UpdateTitle();
-            return true;
-        }
-    }
+    if (GetSaveFileNameA(&ofn)) return SaveToFile(ofn.lpstrFile, wait);
     return false;
 }
 
-bool DoFileSave()
+// wait = false saves in the background (menu/autosave); prompts that must know the outcome wait
+bool DoFileSave(bool wait = true)
 {
-    if (currentFile.empty()) return DoFileSaveAs();
-    if (SaveToFile(currentFile)) {
-        isModified = false;
-        UpdateTitle();
-        return true;
-    }
-    return false;
+    if (currentFile.empty()) return DoFileSaveAs(wait);
+    return SaveToFile(currentFile, wait);
 }
 
 bool DoFileOpen()
@@ -129,14 +677,183 @@ void DoFileNew()
             if (!DoFileSave()) return;
         }
     }
+    FinishSave();
+    LeaveLargeMode();
     SetWindowTextA(hEdit, "");
     currentFile.clear();
     isModified = false;
     UpdateTitle();
 }
 
+// ---- Find / Replace ----
+
+UINT uFindMsg = 0;           // FINDMSGSTRING, sent by the modeless find/replace dialog
+HWND hFindDlg = NULL;
+FINDREPLACEA g_fr;
+char g_findWhat[256] = "";
+char g_replaceWith[256] = "";
+bool g_matchCase = false;
+unsigned long long g_findAnchor = 0; // show the first match at or after this offset
+bool g_findPending = false;          // a Find Next is waiting on the worker
+
+void StartSearch(const std::string &needle, bool matchCase)
+{
+    CancelSearch();
+    if (needle.empty()) return;
+    std::unique_ptr<SearchJob> job(new SearchJob());
+    job->serial = ++g_searchSerial;
+    job->needle = needle;
+    job->matchCase = matchCase;
+    job->snapshot = SnapshotDocument();
+    SearchJob *j = job.get();
+    HWND notify = hMain;
+    job->worker = std::thread([j, notify] { RunSearch(*j, notify); });
+    g_search = std::move(job);
+    UpdateTitle();
+}
+
+void ShowMatch(unsigned long long pos, size_t len)
+{
+    if (!largeMode) {
+        SendMessageA(hEdit, EM_SETSEL, (WPARAM)pos, (LPARAM)(pos + len));
+        SendMessageA(hEdit, EM_SCROLLCARET, 0, 0);
+        return;
+    }
+    g_view.hlStart = pos;
+    g_view.hlLen = len;
+    size_t line = g_lines.LineOf(pos);
+    RECT rc;
+    GetClientRect(hView, &rc);
+    int cols = std::max(1, (int)(rc.right / g_view.charW));
+    long long col = (long long)(pos - g_lines.LineStart(line));
+    int leftCol = g_view.leftCol;
+    if (col < leftCol || col + (long long)len > leftCol + cols) leftCol = (int)std::max(0LL, col - 8);
+    ViewScrollTo((long long)line - ViewRows() / 3, leftCol);
+    InvalidateRect(hView, NULL, FALSE);
+}
+
+// show the first match at or after the anchor; wrap to the top once the scan is complete
+void TryShowMatch()
+{
+    if (!g_findPending || !g_search) return;
+    unsigned long long pos = 0;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lk(g_search->mu);
+        std::vector<unsigned long long> &hits = g_search->hits;
+        auto it = std::lower_bound(hits.begin(), hits.end(), g_findAnchor);
+        if (it != hits.end()) { pos = *it; found = true; }
+        else if (g_search->done && !hits.empty()) { pos = hits.front(); found = true; }
+    }
+    if (found) {
+        // a match beyond the indexed lines waits for the line index to get there
+        if (largeMode && !g_lines.Done() && (!g_lines.Count() || pos >= g_lines.LineStart(g_lines.Count() - 1))) return;
+        g_findPending = false;
+        ShowMatch(pos, g_search->needle.size());
+    } else if (g_search->done) {
+        g_findPending = false;
+        MessageBoxA(hFindDlg ? hFindDlg : hMain, ("Cannot find \"" + g_search->needle + "\"").c_str(), "Find", MB_OK | MB_ICONINFORMATION);
+    }
+}
+
+void FindNext(const std::string &needle, bool matchCase)
+{
+    if (needle.empty()) return;
+    if (!g_search || g_search->needle != needle || g_search->matchCase != matchCase) StartSearch(needle, matchCase);
+    // continue just past the current match/selection
+    if (largeMode) {
+        if (g_view.hlLen) g_findAnchor = g_view.hlStart + 1;
+        else g_findAnchor = g_lines.Count() ? g_lines.LineStart(std::min(g_view.top, g_lines.Count() - 1)) : 0;
+    } else {
+        DWORD selStart = 0, selEnd = 0;
+        SendMessageA(hEdit, EM_GETSEL, (WPARAM)&selStart, (LPARAM)&selEnd);
+        g_findAnchor = selEnd > selStart ? selStart + 1 : selEnd;
+    }
+    g_findPending = true;
+    TryShowMatch();
+}
+
+void DoReplaceAll()
+{
+    g_replaceSerial = 0;
+    if (!g_search || largeMode) return;
+    std::vector<unsigned long long> hits;
+    {
+        std::lock_guard<std::mutex> lk(g_search->mu);
+        hits = g_search->hits;
+    }
+    if (hits.empty()) {
+        MessageBoxA(hFindDlg ? hFindDlg : hMain, ("Cannot find \"" + g_search->needle + "\"").c_str(), "Replace", MB_OK | MB_ICONINFORMATION);
+        return;
+    }
+    // edit a copy of the scanned snapshot back to front so earlier offsets stay valid
+    SoftGUI::TextBuffer doc = g_search->snapshot;
+    size_t m = g_search->needle.size();
+    for (auto it = hits.rbegin(); it != hits.rend(); ++it) doc.replace((size_t)*it, m, g_replaceWith);
+    std::string text = doc.str();
+    SendMessageA(hEdit, EM_SETSEL, 0, -1);
+    SendMessageA(hEdit, EM_REPLACESEL, TRUE, (LPARAM)text.c_str()); // one undoable edit
+    std::string msg = "Replaced " + std::to_string(hits.size()) + " occurrence(s).";
+    MessageBoxA(hFindDlg ? hFindDlg : hMain, msg.c_str(), "Replace", MB_OK | MB_ICONINFORMATION);
+}
+
+void OnFindMessage(FINDREPLACEA *fr)
+{
+    if (fr->Flags & FR_DIALOGTERM) { hFindDlg = NULL; return; }
+    g_matchCase = (fr->Flags & FR_MATCHCASE) != 0;
+    std::string needle = g_findWhat;
+    if (fr->Flags & FR_FINDNEXT) {
+        FindNext(needle, g_matchCase);
+    } else if (fr->Flags & (FR_REPLACE | FR_REPLACEALL)) {
+        if (largeMode) {
+            MessageBoxA(hFindDlg, "Large files are opened read-only.", "Replace", MB_OK | MB_ICONINFORMATION);
+            return;
+        }
+        if (!g_search || g_search->needle != needle || g_search->matchCase != g_matchCase) StartSearch(needle, g_matchCase);
+        if (fr->Flags & FR_REPLACEALL) {
+            if (!g_search) return;
+            g_replaceSerial = g_search->serial; // runs once this scan completes
+            if (g_search->done) DoReplaceAll();
+            return;
+        }
+        // Replace: swap the selection if it is the current match, then move on
+        DWORD selStart = 0, selEnd = 0;
+        SendMessageA(hEdit, EM_GETSEL, (WPARAM)&selStart, (LPARAM)&selEnd);
+        bool isMatch = false;
+        if (g_search && selEnd - selStart == needle.size()) {
+            std::lock_guard<std::mutex> lk(g_search->mu);
+            isMatch = std::binary_search(g_search->hits.begin(), g_search->hits.end(), (unsigned long long)selStart);
+        }
+        if (isMatch) SendMessageA(hEdit, EM_REPLACESEL, TRUE, (LPARAM)g_replaceWith); // restarts the search
+        FindNext(needle, g_matchCase);
+    }
+}
+
+void ShowFindDialog(bool replace)
+{
+    if (replace && largeMode) return;
+    if (hFindDlg) DestroyWindow(hFindDlg);
+    ZeroMemory(&g_fr, sizeof(g_fr));
+    g_fr.lStructSize = sizeof(g_fr);
+    g_fr.hwndOwner = hMain;
+    g_fr.lpstrFindWhat = g_findWhat;
+    g_fr.wFindWhatLen = sizeof(g_findWhat);
+    g_fr.Flags = FR_DOWN | FR_HIDEUPDOWN | (g_matchCase ? FR_MATCHCASE : 0);
+    if (replace) {
+        g_fr.lpstrReplaceWith = g_replaceWith;
+        g_fr.wReplaceWithLen = sizeof(g_replaceWith);
+        hFindDlg = ReplaceTextA(&g_fr);
+    } else {
+        hFindDlg = FindTextA(&g_fr);
+    }
+}
+
 LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
+    if (uFindMsg && msg == uFindMsg) {
+        OnFindMessage((FINDREPLACEA *)lParam);
+        return 0;
+    }
     switch (msg) {
     case WM_CREATE:
     {
@@ -147,15 +864,24 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         AppendMenuA(hFile, MF_STRING, IDM_FILE_OPEN, "&Open...\tCtrl+O");
         AppendMenuA(hFile, MF_STRING, IDM_FILE_SAVE, "&Save\tCtrl+S");
         AppendMenuA(hFile, MF_STRING, IDM_FILE_SAVEAS, "Save &As...");
+        AppendMenuA(hFile, MF_STRING, IDM_FILE_AUTOSAVE, "A&utosave");
         AppendMenuA(hFile, MF_SEPARATOR, 0, NULL);
         AppendMenuA(hFile, MF_STRING, IDM_FILE_EXIT, "E&xit");
         AppendMenuA(hMenubar, MF_POPUP, (UINT_PTR)hFile, "&File");
+        HMENU hEditMenu = CreatePopupMenu();
+        AppendMenuA(hEditMenu, MF_STRING, IDM_EDIT_FIND, "&Find...\tCtrl+F");
+        AppendMenuA(hEditMenu, MF_STRING, IDM_EDIT_FINDNEXT, "Find &Next\tF3");
+        AppendMenuA(hEditMenu, MF_STRING, IDM_EDIT_REPLACE, "&Replace...\tCtrl+H");
+        AppendMenuA(hMenubar, MF_POPUP, (UINT_PTR)hEditMenu, "&Edit");
         SetMenu(hWnd, hMenubar);
 
         // Create multi-line edit control
         hEdit = CreateWindowExA(0, "EDIT", "",
                                  WS_CHILD | WS_VISIBLE | WS_VSCROLL | WS_HSCROLL | ES_MULTILINE | ES_AUTOVSCROLL | ES_AUTOHSCROLL | ES_WANTRETURN | WS_BORDER,
                                  0, 0, 100, 100, hWnd, (HMENU)1, ((LPCREATESTRUCT)lParam)->hInstance, NULL);
+        // lift the 32K default: it caps EM_REPLACESEL (but not SetWindowText), so replacing in a
+        // larger document would truncate it
+        SendMessageA(hEdit, EM_SETLIMITTEXT, 0, 0);
 
         // Set a monospaced font for the edit control
         HFONT hFont = CreateFontA(-12, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
@@ -163,16 +889,31 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
                                   FIXED_PITCH | FF_MODERN, "Consolas");
         SendMessageA(hEdit, WM_SETFONT, (WPARAM)hFont, TRUE);
 
+        // Large-file view (hidden until a big file is opened), same font
+        hView = CreateWindowExA(0, "SoftLargeTextView", "", WS_CHILD | WS_VSCROLL | WS_HSCROLL | WS_BORDER,
+                                0, 0, 100, 100, hWnd, (HMENU)2, ((LPCREATESTRUCT)lParam)->hInstance, NULL);
+        g_view.font = hFont;
+        HDC hdc = GetDC(hWnd);
+        HGDIOBJ old = SelectObject(hdc, hFont);
+        TEXTMETRICA tm;
+        GetTextMetricsA(hdc, &tm);
+        g_view.lineH = tm.tmHeight + tm.tmExternalLeading;
+        g_view.charW = tm.tmAveCharWidth;
+        SelectObject(hdc, old);
+        ReleaseDC(hWnd, hdc);
+
         UpdateTitle();
     }
     return 0;
 
     case WM_SIZE:
         if (hEdit) SetWindowPos(hEdit, NULL, 0, 0, LOWORD(lParam), HIWORD(lParam), SWP_NOZORDER);
+        if (hView) SetWindowPos(hView, NULL, 0, 0, LOWORD(lParam), HIWORD(lParam), SWP_NOZORDER);
         return 0;
 
     case WM_SETFOCUS:
-        if (hEdit) SetFocus(hEdit);
+        if (largeMode && hView) SetFocus(hView);
+        else if (hEdit) SetFocus(hEdit);
         return 0;
 
     case WM_COMMAND:
@@ -180,13 +921,27 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         switch (LOWORD(wParam)) {
         case IDM_FILE_NEW: DoFileNew(); break;
         case IDM_FILE_OPEN: DoFileOpen(); break;
-        case IDM_FILE_SAVE: DoFileSave(); break;
-        case IDM_FILE_SAVEAS: DoFileSaveAs(); break;
+        case IDM_FILE_SAVE: DoFileSave(false); break;
+        case IDM_FILE_SAVEAS: DoFileSaveAs(false); break;
+        case IDM_FILE_AUTOSAVE:
+            autosave = !autosave;
+            CheckMenuItem(GetMenu(hWnd), IDM_FILE_AUTOSAVE, autosave ? MF_CHECKED : MF_UNCHECKED);
+            if (autosave) SetTimer(hWnd, AUTOSAVE_TIMER_ID, kAutosaveIntervalMs, NULL);
+            else KillTimer(hWnd, AUTOSAVE_TIMER_ID);
+            break;
         case IDM_FILE_EXIT: PostMessageA(hWnd, WM_CLOSE, 0, 0); break;
+        case IDM_EDIT_FIND: ShowFindDialog(false); break;
+        case IDM_EDIT_FINDNEXT:
+            if (g_findWhat[0]) FindNext(g_findWhat, g_matchCase);
+            else ShowFindDialog(false);
+            break;
+        case IDM_EDIT_REPLACE: ShowFindDialog(true); break;
         default:
             // Edit notifications
             if (HIWORD(wParam) == EN_CHANGE && (HWND)lParam == hEdit) {
+                ++editCount;
                 isModified = true;
+                CancelSearch(); // match offsets no longer apply
                 UpdateTitle();
             }
             break;
@@ -194,7 +949,31 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
     }
     return 0;
 
+    case WM_APP_SAVE_PROGRESS:
+        if (g_save && g_save->serial == (unsigned)wParam) UpdateTitle();
+        return 0;
+
+    case WM_APP_SAVE_DONE:
+        if (g_save && g_save->serial == (unsigned)wParam) FinishSave();
+        return 0;
+
+    case WM_APP_SEARCH_PROGRESS:
+    case WM_APP_SEARCH_DONE:
+        if (g_search && g_search->serial == (unsigned)wParam) {
+            TryShowMatch();
+            if (msg == WM_APP_SEARCH_DONE && g_replaceSerial == g_search->serial && !largeMode) DoReplaceAll();
+            UpdateTitle();
+        }
+        return 0;
+
+    case WM_TIMER:
+        // autosave only a named, modified, editable document, and never over a running save
+        if (wParam == AUTOSAVE_TIMER_ID && isModified && !currentFile.empty() && !largeMode && !g_save)
+            SaveToFile(currentFile, false);
+        return 0;
+
     case WM_CLOSE:
+        if (!FinishSave()) return 0;
         if (isModified) {
             int r = MessageBoxA(hWnd, "There are unsaved changes. Save before exiting?", "Unsaved Changes", MB_YESNOCANCEL | MB_ICONWARNING);
             if (r == IDCANCEL) return 0;
@@ -206,6 +985,9 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         return 0;
 
     case WM_DESTROY:
+        KillTimer(hWnd, AUTOSAVE_TIMER_ID);
+        CancelSearch();
+        g_lines.Stop();
         PostQuitMessage(0);
         return 0;
     }
@@ -222,6 +1004,14 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
     wc.lpszClassName = "SoftTextEditorClass";
 
     if (!RegisterClassA(&wc)) return -1;
+    uFindMsg = RegisterWindowMessageA(FINDMSGSTRING);
+
+    WNDCLASSA vc = {0};
+    vc.lpfnWndProc = LargeViewProc;
+    vc.hInstance = hInstance;
+    vc.hCursor = LoadCursor(NULL, IDC_IBEAM);
+    vc.lpszClassName = "SoftLargeTextView";
+    if (!RegisterClassA(&vc)) return -1;
 
     hMain = CreateWindowA(wc.lpszClassName, "Soft Text Editor", WS_OVERLAPPEDWINDOW | WS_VISIBLE,
                           CW_USEDEFAULT, CW_USEDEFAULT, 900, 600, NULL, NULL, hInstance, NULL);
@@ -231,11 +1021,24 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
     ShowWindow(hMain, nCmdShow);
     UpdateWindow(hMain);
 
+    ACCEL accels[] = {
+        { FCONTROL | FVIRTKEY, 'N', IDM_FILE_NEW },
+        { FCONTROL | FVIRTKEY, 'O', IDM_FILE_OPEN },
+        { FCONTROL | FVIRTKEY, 'S', IDM_FILE_SAVE },
+        { FCONTROL | FVIRTKEY, 'F', IDM_EDIT_FIND },
+        { FCONTROL | FVIRTKEY, 'H', IDM_EDIT_REPLACE },
+        { FVIRTKEY, VK_F3, IDM_EDIT_FINDNEXT },
+    };
+    HACCEL hAccel = CreateAcceleratorTableA(accels, sizeof(accels) / sizeof(accels[0]));
+
     MSG msg;
     while (GetMessageA(&msg, NULL, 0, 0)) {
+        if (hFindDlg && IsDialogMessageA(hFindDlg, &msg)) continue;
+        if (TranslateAcceleratorA(hMain, hAccel, &msg)) continue;
         TranslateMessage(&msg);
         DispatchMessageA(&msg);
     }
 
+    DestroyAcceleratorTable(hAccel);
     return (int)msg.wParam;
 }